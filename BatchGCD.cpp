@@ -0,0 +1,236 @@
+#include "BatchGCD.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+
+namespace RSAUtil
+{
+
+BatchGCD::BatchGCD(int threadCount, const std::string& dir)
+	: threads(threadCount < 1 ? 1 : threadCount), spillDir(dir)
+{
+}
+
+BatchGCD::~BatchGCD()
+{
+}
+
+// floor(2^(2*64n) / b) for an n-limb b.  The top half of b gives a reciprocal good
+// to about n/2 limbs, one Newton step x + x(2^(128n) - xb)/2^(128n) doubles that,
+// and the last few units are corrected against the exact residue.
+static BigNum reciprocal(const BigNum& b){
+	int n = b.size();
+	BigNum one = BigNum(1) << (2*n*LIMB_BITS);
+	if(n <= BATCHGCD_NEWTON_CUTOFF){
+		return one / b;
+	}
+	int k = n/2 + 2;
+	BigNum x = reciprocal(b >> ((n-k)*LIMB_BITS)) << ((n-k)*LIMB_BITS);
+	BigNum xb = x * b;
+	if(xb > one){
+		x -= (x * (xb - one)) >> (2*n*LIMB_BITS);
+	}
+	else{
+		x += (x * (one - xb)) >> (2*n*LIMB_BITS);
+	}
+	xb = x * b;
+	while(xb > one){
+		x -= 1;
+		xb -= b;
+	}
+	while(one - xb >= b){
+		x += 1;
+		xb += b;
+	}
+	return x;
+}
+
+// a mod b by Barrett reduction, given inv = reciprocal(b).  Each step reduces a
+// value below b*2^(64n), so a longer a is reduced from its top n limbs down.
+static BigNum reduce(const BigNum& a, const BigNum& b, const BigNum& inv){
+	int n = b.size();
+	if(n <= BATCHGCD_NEWTON_CUTOFF){
+		return a % b;
+	}
+	if(a < b){
+		return a;
+	}
+	BigNum t = a;
+	if(a.size() > 2*n){
+		BigNum low;
+		low.setLimbs(a.limbs(), n);
+		t = (reduce(a >> (n*LIMB_BITS), b, inv) << (n*LIMB_BITS)) + low;
+	}
+	//The estimate never exceeds the true quotient and is short by at most 2.
+	BigNum q = ((t >> ((n-1)*LIMB_BITS)) * inv) >> ((n+1)*LIMB_BITS);
+	BigNum r = t - q*b;
+	while(r >= b){
+		r -= b;
+	}
+	return r;
+}
+
+// out[i] = in[2i] * in[2i+1]; an odd node out is carried up as it is.
+void BatchGCD::productRange(LevelJob job, size_t first, size_t step){
+	const std::vector<BigNum>& in = *job.in;
+	std::vector<BigNum>& out = *job.out;
+	for(size_t i=first; i<out.size(); i+=step){
+		if(2*i + 1 < in.size()){
+			BigNum::mul(out[i], in[2*i], in[2*i + 1]);
+		}
+		else{
+			out[i] = in[2*i];
+		}
+	}
+}
+
+// out[i] = in[i/2] mod level[i]^2.
+void BatchGCD::remainderRange(LevelJob job, size_t first, size_t step){
+	const std::vector<BigNum>& in = *job.in;
+	const std::vector<BigNum>& level = *job.level;
+	std::vector<BigNum>& out = *job.out;
+	for(size_t i=first; i<out.size(); i+=step){
+		BigNum sq;
+		BigNum::sqr(sq, level[i]);
+		out[i] = reduce(in[i/2], sq, reciprocal(sq));
+	}
+}
+
+// out[i] = gcd(in[i]/level[i], level[i]), in[i] being a multiple of level[i].
+void BatchGCD::gcdRange(LevelJob job, size_t first, size_t step){
+	const std::vector<BigNum>& in = *job.in;
+	const std::vector<BigNum>& level = *job.level;
+	std::vector<BigNum>& out = *job.out;
+	for(size_t i=first; i<out.size(); i+=step){
+		out[i] = gcd(in[i] / level[i], level[i]);
+	}
+}
+
+//Runs fn over count nodes, thread t taking nodes t, t + threads, ...
+void BatchGCD::runLevel(void (*fn)(LevelJob, size_t, size_t), LevelJob job, size_t count) const{
+	size_t workers = ((size_t)threads < count) ? (size_t)threads : count;
+	std::vector<std::thread> pool;
+	for(size_t t=1; t<workers; t++){
+		pool.push_back(std::thread(fn, job, t, workers));
+	}
+	fn(job, 0, workers);
+	for(size_t t=0; t<pool.size(); t++){
+		pool[t].join();
+	}
+}
+
+std::string BatchGCD::spillFile(int level) const{
+	std::ostringstream name;
+	name << spillDir << "/batchgcd-" << getpid() << "-" << (const void*)this << "-" << level;
+	return name.str();
+}
+
+//Each number is written as its limb count followed by its limbs.
+bool BatchGCD::spill(int level, const std::vector<BigNum>& nums) const{
+	std::ofstream out(spillFile(level).c_str(), std::ios::binary);
+	unsigned long long count = nums.size();
+	out.write((const char*)&count, sizeof(count));
+	for(size_t i=0; i<nums.size(); i++){
+		int size = nums[i].size();
+		out.write((const char*)&size, sizeof(size));
+		out.write((const char*)nums[i].limbs(), size*sizeof(limb_t));
+	}
+	out.close();
+	return !out.fail();
+}
+
+bool BatchGCD::unspill(int level, std::vector<BigNum>& nums) const{
+	std::string file = spillFile(level);
+	std::ifstream in(file.c_str(), std::ios::binary);
+	unsigned long long count = 0;
+	in.read((char*)&count, sizeof(count));
+	nums.assign(in ? count : 0, BigNum());
+	std::vector<limb_t> limbs;
+	for(size_t i=0; in && i<nums.size(); i++){
+		int size = 0;
+		in.read((char*)&size, sizeof(size));
+		limbs.resize(size > 0 ? size : 1);
+		in.read((char*)&limbs[0], size*sizeof(limb_t));
+		nums[i].setLimbs(&limbs[0], size);
+	}
+	bool ok = !in.fail();
+	in.close();
+	std::remove(file.c_str());
+	return ok;
+}
+
+bool BatchGCD::gcds(const std::vector<BigNum>& moduli, std::vector<BigNum>& out) const{
+	out.assign(moduli.size(), BigNum());
+	if(moduli.empty()){
+		return true;
+	}
+	bool spilling = !spillDir.empty();
+	bool ok = true;
+
+	//Product tree.  levels[0] stays empty: level 0 is the moduli themselves.
+	std::vector<std::vector<BigNum> > levels(1);
+	const std::vector<BigNum>* below = &moduli;
+	std::vector<BigNum> current;
+	int top = 0;
+	while(below->size() > 1){
+		std::vector<BigNum> above((below->size() + 1) / 2);
+		LevelJob job = {below, 0, &above};
+		runLevel(productRange, job, above.size());
+		top++;
+		if(top > 1){
+			if(spilling){
+				ok = spill(top - 1, current) && ok;
+				current.clear();
+			}
+			else{
+				levels.push_back(std::vector<BigNum>());
+				levels.back().swap(current);
+			}
+		}
+		current.swap(above);
+		below = &current;
+	}
+
+	//Remainder tree: the root's remainder is P itself.
+	std::vector<BigNum> rem(1, top > 0 ? current[0] : moduli[0]);
+	for(int level=top-1; level>=0 && ok; level--){
+		std::vector<BigNum> loaded;
+		const std::vector<BigNum>* nodes = &moduli;
+		if(level > 0){
+			if(spilling){
+				ok = unspill(level, loaded);
+			}
+			else{
+				loaded.swap(levels[level]);
+			}
+			if(!ok){
+				break;
+			}
+			nodes = &loaded;
+		}
+		std::vector<BigNum> next(nodes->size());
+		LevelJob job = {&rem, nodes, &next};
+		runLevel(remainderRange, job, next.size());
+		rem.swap(next);
+	}
+	//Remove what an I/O failure left behind.
+	for(int level=1; spilling && !ok && level<top; level++){
+		std::remove(spillFile(level).c_str());
+	}
+	if(!ok){
+		return false;
+	}
+
+	//gi = gcd(ri/ni, ni); ri = P mod ni^2 is a multiple of ni.
+	if(top == 0){
+		out[0] = 1;
+		return true;
+	}
+	LevelJob job = {&rem, &moduli, &out};
+	runLevel(gcdRange, job, out.size());
+	return true;
+}
+
+}
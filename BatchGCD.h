@@ -0,0 +1,89 @@
+#ifndef BATCHGCD_H_
+#define BATCHGCD_H_
+#include <string>
+#include <vector>
+#include "BigNum.h"
+
+namespace RSAUtil
+{
+
+//Below this many limbs remainders are taken by long division; above it by Barrett
+//reduction with a reciprocal found by Newton's iteration, which costs a few
+//multiplications and so keeps the top of the remainder tree quasi-linear.
+#define BATCHGCD_NEWTON_CUTOFF 64
+
+/****************************************************************************************
+ * Bernstein's batch GCD: finds every modulus in a set that shares a prime with another
+ * one, in time quasi-linear in the total size of the set rather than one gcd per pair.
+ *
+ *	product tree:	level 0 holds the moduli and each level above holds the products
+ *					of pairs from the one below, up to P, the product of them all.
+ *	remainder tree:	going back down, each node gets P mod (its product)^2, reduced
+ *					from its parent's remainder; at the leaves ri = P mod ni^2.
+ *	gcds:			gi = gcd(ri/ni, ni), which is gcd(ni, product of the others).
+ *
+ * Each level of both trees is split between the given number of threads.  With a
+ * spill directory every level of the product tree is written out as soon as the
+ * level above it is built and read back on the way down, so only two levels are in
+ * memory at a time; this is what makes audits of millions of keys fit.  The files
+ * are removed as they are read.
+ *
+ * @class: BatchGCD
+ * @namespace: RSAUtil
+ * @file: BatchGCD.h
+ * @version: 1.0.0.0
+ * @date: 10/18/2026
+ * **************************************************************************************
+ */
+class BatchGCD
+{
+private:
+	int threads;
+	std::string spillDir;
+
+	//One level of either tree, split between the threads.
+	struct LevelJob
+	{
+		const std::vector<BigNum>* in;
+		const std::vector<BigNum>* level;
+		std::vector<BigNum>* out;
+	};
+
+	static void productRange(LevelJob, size_t, size_t);
+	static void remainderRange(LevelJob, size_t, size_t);
+	static void gcdRange(LevelJob, size_t, size_t);
+	void runLevel(void (*)(LevelJob, size_t, size_t), LevelJob, size_t) const;
+
+	std::string spillFile(int) const;
+	bool spill(int, const std::vector<BigNum>&) const;
+	bool unspill(int, std::vector<BigNum>&) const;
+
+public:
+	/*
+	 * *******************************************************************************
+	 * Constructor.
+	 * @parameter int:	Number of threads to split each tree level between.
+	 * @parameter std::string:	Directory to spill the product tree to, or empty to
+	 * 							keep it in memory.
+	 * *******************************************************************************
+	 */
+	BatchGCD(int threads = 1, const std::string& spillDir = "");
+	virtual ~BatchGCD();
+
+	/*
+	 * *******************************************************************************
+	 * gcds.	For every modulus, its gcd with the product of all the others.  1 means
+	 * 			it shares no prime with the rest of the set; the modulus itself means
+	 * 			every prime of it is shared, as with a duplicated key, and only a
+	 * 			pairwise gcd against the other weak moduli will split it.
+	 * @parameter std::vector<BigNum>:	The moduli, all greater than 1.
+	 * @parameter std::vector<BigNum>:	Receives the gcds, in the same order.
+	 * @returns bool:	False if the spill directory could not be written or read.
+	 * *******************************************************************************
+	 */
+	bool gcds(const std::vector<BigNum>&, std::vector<BigNum>&) const;
+};
+
+}
+
+#endif /*BATCHGCD_H_*/
@@ -0,0 +1,250 @@
+#include "BatchRSA.h"
+
+namespace RSAUtil
+{
+
+// One node of the batch tree.  Leaves refer to their entry in the request.
+struct BatchRSA::Node
+{
+	//Product of the public exponents below this node.
+	BigNum E;
+	//m^E mod n, m the product of the messages below this node.
+	BigNum v;
+	int left;
+	int right;
+	//Index of the ciphertext for a leaf, -1 otherwise.
+	int entry;
+};
+
+BatchRSA::BatchRSA(const std::vector<PrivateKey>& keyList) : keys(keyList)
+{
+	usable = (keys.size() >= 2);
+	if(usable){
+		primes = keys[0].getPrimes();
+		const BigNum& n = keys[0].getModulus();
+		usable = (primes.size() >= 2 && n.isOdd());
+		for(size_t i=0; usable && i<keys.size(); i++){
+			usable = (keys[i].getModulus() == n) && (keys[i].getPublicExponent() > 1)
+				&& !keys[i].getExponent().isZero();
+			for(size_t j=0; usable && j<i; j++){
+				usable = (gcd(keys[i].getPublicExponent(), keys[j].getPublicExponent()) == 1);
+			}
+		}
+	}
+	if(!usable){
+		return;
+	}
+
+	BigNum E(1);
+	phi = 1;
+	for(size_t i=0; i<primes.size(); i++){
+		phi *= primes[i] - 1;
+	}
+	for(size_t i=0; i<keys.size(); i++){
+		E *= keys[i].getPublicExponent();
+	}
+	//Without E^-1 mod phi there is no root to take; modInverse() would give 0.
+	//With it, every product of a subset of the exponents is invertible too, which
+	//decryptRound() relies on for partial batches.
+	if(gcd(E, phi) != 1){
+		usable = false;
+		return;
+	}
+	mont = std::make_shared<const MontContext>(keys[0].getModulus());
+	fullRoot = std::make_shared<const PrivateKey>(primes, E, modInverse(E, phi));
+}
+
+BatchRSA::~BatchRSA()
+{
+}
+
+bool BatchRSA::isBatched() const{
+	return usable;
+}
+
+const std::vector<PrivateKey>& BatchRSA::getKeys() const{
+	return keys;
+}
+
+//The terms of a^x * b^y for multiPow().
+static std::vector<std::pair<BigNum, BigNum> > powTerms(const BigNum& a, const BigNum& x,
+		const BigNum& b, const BigNum& y){
+	std::vector<std::pair<BigNum, BigNum> > terms;
+	terms.push_back(std::make_pair(a, x));
+	terms.push_back(std::make_pair(b, y));
+	return terms;
+}
+
+//Builds the tree over round[lo..hi-1] and returns the index of its root.
+int BatchRSA::buildUp(std::vector<Node>& nodes, const std::vector<size_t>& round,
+		const std::vector<int>& keyIndex, const std::vector<BigNum>& ciphers,
+		int lo, int hi) const{
+	Node node;
+	node.left = -1;
+	node.right = -1;
+	node.entry = -1;
+	if(hi - lo == 1){
+		node.entry = round[lo];
+		node.E = keys[keyIndex[node.entry]].getPublicExponent();
+		node.v = ciphers[node.entry] % mont->getModulus();
+	}
+	else{
+		int mid = lo + (hi - lo)/2;
+		node.left = buildUp(nodes, round, keyIndex, ciphers, lo, mid);
+		node.right = buildUp(nodes, round, keyIndex, ciphers, mid, hi);
+		const Node& l = nodes[node.left];
+		const Node& r = nodes[node.right];
+		node.E = l.E * r.E;
+		node.v = mont->multiPow(powTerms(l.v, r.E, r.v, l.E));
+	}
+	nodes.push_back(node);
+	return (int)nodes.size() - 1;
+}
+
+// Replaces every value with its inverse mod n using one modInverse (Montgomery's
+// trick).  False, with the values unchanged, if any of them is not invertible.
+static bool invertAll(std::vector<BigNum>& vals, const BigNum& n){
+	if(vals.empty()){
+		return true;
+	}
+	//prefix[i] = vals[0]*...*vals[i].
+	std::vector<BigNum> prefix(vals.size());
+	prefix[0] = vals[0];
+	for(size_t i=1; i<vals.size(); i++){
+		prefix[i] = (prefix[i-1] * vals[i]) % n;
+	}
+	BigNum inv = modInverse(prefix.back(), n);
+	if(inv.isZero()){
+		return false;
+	}
+	for(size_t i=vals.size()-1; i>0; i--){
+		BigNum vi = (inv * prefix[i-1]) % n;
+		inv = (inv * vals[i]) % n;
+		vals[i] = vi;
+	}
+	vals[0] = inv;
+	return true;
+}
+
+//Splits m, the product of the messages below node idx, down to the leaves.  Works a
+//level at a time so each level needs a single inversion.
+void BatchRSA::splitDown(std::vector<Node>& nodes, int idx, const BigNum& m,
+		const std::vector<int>& keyIndex, const std::vector<BigNum>& ciphers,
+		std::vector<BigNum>& out) const{
+	const BigNum& n = mont->getModulus();
+	std::vector<int> level(1, idx);
+	std::vector<BigNum> values(1, m);
+
+	while(!level.empty()){
+		std::vector<int> next;
+		std::vector<BigNum> nums;
+		std::vector<BigNum> dens;
+		for(size_t i=0; i<level.size(); i++){
+			const Node& node = nodes[level[i]];
+			if(node.entry >= 0){
+				out[node.entry] = values[i];
+				continue;
+			}
+			const Node& l = nodes[node.left];
+			const Node& r = nodes[node.right];
+			//XL = 1 mod EL, 0 mod ER, and XR = 0 mod EL, 1 mod ER; then
+			//mL = m^XL / (vL^((XL-1)/EL) * vR^(XL/ER)) and likewise for mR.
+			BigNum XL = r.E * modInverse(r.E % l.E, l.E);
+			BigNum XR = l.E * modInverse(l.E % r.E, r.E);
+			nums.push_back(mont->pow(values[i], XL));
+			dens.push_back(mont->multiPow(powTerms(l.v, (XL - 1) / l.E, r.v, XL / r.E)));
+			nums.push_back(mont->pow(values[i], XR));
+			dens.push_back(mont->multiPow(powTerms(l.v, XR / l.E, r.v, (XR - 1) / r.E)));
+			next.push_back(node.left);
+			next.push_back(node.right);
+		}
+		if(!invertAll(dens, n)){
+			//A ciphertext shares a factor with n; decrypt the rest one by one.
+			while(!next.empty()){
+				const Node& p = nodes[next.back()];
+				next.pop_back();
+				if(p.entry >= 0){
+					out[p.entry] = keys[keyIndex[p.entry]].decrypt(ciphers[p.entry]);
+				}
+				else{
+					next.push_back(p.left);
+					next.push_back(p.right);
+				}
+			}
+			return;
+		}
+		values.resize(next.size());
+		for(size_t i=0; i<next.size(); i++){
+			values[i] = (nums[i] * dens[i]) % n;
+		}
+		level.swap(next);
+	}
+}
+
+void BatchRSA::decryptRound(const std::vector<size_t>& round, const std::vector<int>& keyIndex,
+		const std::vector<BigNum>& ciphers, RootCache& roots, std::vector<BigNum>& out) const{
+	if(round.size() == 1){
+		out[round[0]] = keys[keyIndex[round[0]]].decrypt(ciphers[round[0]]);
+		return;
+	}
+	std::vector<Node> nodes;
+	nodes.reserve(2*round.size());
+	int root = buildUp(nodes, round, keyIndex, ciphers, 0, (int)round.size());
+
+	std::shared_ptr<const PrivateKey> rootKey = fullRoot;
+	if(round.size() < keys.size()){
+		std::vector<bool> subset(keys.size(), false);
+		for(size_t i=0; i<round.size(); i++){
+			subset[keyIndex[round[i]]] = true;
+		}
+		std::shared_ptr<const PrivateKey>& cached = roots[subset];
+		if(!cached){
+			//E divides the full product, so the constructor's check covers it.
+			const BigNum& E = nodes[root].E;
+			cached = std::make_shared<const PrivateKey>(primes, E, modInverse(E, phi));
+		}
+		rootKey = cached;
+	}
+	BigNum m = rootKey->decrypt(nodes[root].v);
+	splitDown(nodes, root, m, keyIndex, ciphers, out);
+}
+
+std::vector<BigNum> BatchRSA::decrypt(const std::vector<int>& keyIndex,
+		const std::vector<BigNum>& ciphers) const{
+	if(keyIndex.size() < ciphers.size()){
+		return std::vector<BigNum>();
+	}
+	for(size_t i=0; i<ciphers.size(); i++){
+		if(keyIndex[i] < 0 || (size_t)keyIndex[i] >= keys.size()){
+			return std::vector<BigNum>();
+		}
+	}
+	std::vector<BigNum> out(ciphers.size());
+	if(!usable){
+		for(size_t i=0; i<ciphers.size(); i++){
+			out[i] = keys[keyIndex[i]].decrypt(ciphers[i]);
+		}
+		return out;
+	}
+
+	//Each round takes the first outstanding ciphertext of every key.
+	RootCache roots;
+	std::vector<bool> done(ciphers.size(), false);
+	size_t remaining = ciphers.size();
+	while(remaining > 0){
+		std::vector<bool> used(keys.size(), false);
+		std::vector<size_t> round;
+		for(size_t i=0; i<ciphers.size(); i++){
+			if(!done[i] && !used[keyIndex[i]]){
+				used[keyIndex[i]] = true;
+				done[i] = true;
+				round.push_back(i);
+			}
+		}
+		decryptRound(round, keyIndex, ciphers, roots, out);
+		remaining -= round.size();
+	}
+	return out;
+}
+
+}
@@ -0,0 +1,101 @@
+#ifndef BATCHRSA_H_
+#define BATCHRSA_H_
+#include <map>
+#include <memory>
+#include <vector>
+#include "RSAKey.h"
+
+namespace RSAUtil
+{
+
+/****************************************************************************************
+ * Fiat's batch RSA decryption.  The keys all share one modulus n = p*q (or more
+ * primes) and have small, pairwise coprime public exponents e1..eb, e.g. keys built
+ * from one RSA object with setPublicKey(3), setPublicKey(5), ... and
+ * buildPrivateKey().  A batch holding one ciphertext per key is decrypted with a
+ * single full-size exponentiation:
+ *
+ *	up:		a binary tree over the batch; a leaf holds (ei, ci) and an inner node
+ *			(E, v) = (EL*ER, vL^ER * vR^EL), so every node has v = m^E, where m is
+ *			the product of the messages below it.
+ *	root:	m = v^(1/E), through the CRT with E^-1 mod phi.
+ *	down:	with X = 0 mod EL and 1 mod ER, a node's m splits into
+ *			mR = m^X / (vL^(X/EL) * vR^((X-1)/ER)), and mL likewise.
+ *
+ * Everything but the root costs a few small-exponent powers per node, plus one
+ * modular inversion per tree level (the denominators of a level are inverted
+ * together).  Ciphertexts for the same key go into separate batches.
+ *
+ * @class: BatchRSA
+ * @namespace: RSAUtil
+ * @file: BatchRSA.h
+ * @version: 1.0.0.0
+ * @date: 10/18/2026
+ * **************************************************************************************
+ */
+class BatchRSA
+{
+private:
+	//The keys, indexed as in the constructor.
+	std::vector<PrivateKey> keys;
+	//Prime factors of the shared modulus, and phi(n).
+	std::vector<BigNum> primes;
+	BigNum phi;
+	//Montgomery context for the shared modulus.
+	std::shared_ptr<const MontContext> mont;
+	//Root key for a batch holding every key; other batches build their own.
+	std::shared_ptr<const PrivateKey> fullRoot;
+	//True if the keys meet the conditions above.
+	bool usable;
+
+	//Root keys of partial batches within one decrypt() call, by the set of keys
+	//in the batch.
+	typedef std::map<std::vector<bool>, std::shared_ptr<const PrivateKey> > RootCache;
+
+	struct Node;
+	int buildUp(std::vector<Node>&, const std::vector<size_t>&, const std::vector<int>&,
+			const std::vector<BigNum>&, int, int) const;
+	void splitDown(std::vector<Node>&, int, const BigNum&, const std::vector<int>&,
+			const std::vector<BigNum>&, std::vector<BigNum>&) const;
+	void decryptRound(const std::vector<size_t>&, const std::vector<int>&,
+			const std::vector<BigNum>&, RootCache&, std::vector<BigNum>&) const;
+
+public:
+	/*
+	 * *******************************************************************************
+	 * Constructor.
+	 * @parameter std::vector<PrivateKey>:	The keys.  If they do not share a modulus
+	 * 					with known factors, a key has no private exponent, or the
+	 * 					public exponents are not pairwise coprime or their product
+	 * 					is not invertible mod phi(n), decrypt() falls back to one
+	 * 					decryption per ciphertext.
+	 * *******************************************************************************
+	 */
+	BatchRSA(const std::vector<PrivateKey>&);
+	virtual ~BatchRSA();
+
+	/*
+	 * *******************************************************************************
+	 * isBatched.	True if decrypt() uses the batch tree.
+	 * *******************************************************************************
+	 */
+	bool isBatched() const;
+
+	const std::vector<PrivateKey>& getKeys() const;
+
+	/*
+	 * *******************************************************************************
+	 * decrypt.	Decrypts ciphertext i with key keyIndex[i].
+	 * @parameter std::vector<int>:	Index into getKeys() for each ciphertext; at
+	 * 					least as many entries as there are ciphertexts.
+	 * @parameter std::vector<BigNum>:	The ciphertexts.
+	 * @returns std::vector<BigNum>:	The messages, in the same order, or an empty
+	 * 					vector if keyIndex is too short or an index is out of range.
+	 * *******************************************************************************
+	 */
+	std::vector<BigNum> decrypt(const std::vector<int>&, const std::vector<BigNum>&) const;
+};
+
+}
+
+#endif /*BATCHRSA_H_*/
@@ -1,4 +1,5 @@
 #include "BigInt.h"
+#include "Limb.h"
 #include <string>
 #include <iostream>
 #include <limits>
@@ -9,40 +10,82 @@
 namespace RSAUtil
 {
 
+//Like the 32 bit word code it replaces, this file depends on BIGINT_SIZE: it is
+//written for two limbs.
+#if BIGINT_LIMBS != 2
+#error "BigInt.cpp expects 65 <= BIGINT_SIZE <= 128"
+#endif
 
+//Mask for the bits of the top limb that lie below BIGINT_SIZE.
+#define BIGINT_TOP_MASK ((BIGINT_SIZE % LIMB_BITS) ? \
+		(((limb_t)1 << (BIGINT_SIZE % LIMB_BITS)) - 1) : ~(limb_t)0)
 
 /* 
  * A class for handling large (64 bit) integers.  
- * Implemented via a bitset.
+ * Implemented via an array of limbs and its significant length.
 */
 BigInt::BigInt()
 {
-	n = 0x0;
+	d[0] = 0;
+	d[1] = 0;
+	used = 0;
 }
 
 
+//As for the original bitset: the ints are sign extended to 64 bits, and lower is
+//or-ed in whole.
 BigInt::BigInt(int upper, int lower)
 {
-	n = upper;
-	n <<= (32);
-	n|=lower;
+	limb_t u = (limb_t)(long long)upper;
+	d[0] = (u << 32) | (limb_t)(long long)lower;
+	d[1] = u >> 32;
+	normalize();
 }
 
 BigInt::BigInt(int lower)
 {
-	n = lower;
+	d[0] = (limb_t)(long long)lower;
+	d[1] = 0;
+	normalize();
 }
 
 BigInt::BigInt(std::bitset<BIGINT_SIZE> num)
 {
-	n = num;
+	std::bitset<BIGINT_SIZE> low(~(limb_t)0);
+	d[0] = (num & low).to_ullong();
+	d[1] = (num >> LIMB_BITS).to_ullong();
+	normalize();
 }
 BigInt::~BigInt()
 {
 }
 
+void BigInt::normalize(){
+	d[BIGINT_LIMBS-1] &= BIGINT_TOP_MASK;
+	used = BIGINT_LIMBS;
+	while(used > 0 && d[used-1] == 0){
+		used--;
+	}
+}
+
 bool BigInt::isZero(){
-	 return n.none();
+	 return used == 0;
+}
+
+int BigInt::bitLength() const{
+	if(used == 0){
+		return 0;
+	}
+	return used*LIMB_BITS - __builtin_clzll(d[used-1]);
+}
+
+int BigInt::lowestSetBit() const{
+	for(int i=0; i<used; i++){
+		if(d[i]){
+			return i*LIMB_BITS + __builtin_ctzll(d[i]);
+		}
+	}
+	return -1;
 }
 
 //passes the BigInt into an array of unsigned longs.  If the array is
@@ -57,22 +100,28 @@ bool BigInt::isZero(){
 
 	
 void BigInt::toULong(unsigned long* arr, int size) const{
-	std::bitset<BIGINT_SIZE> temp;
 	for(int i=0; i<size; i++){
-		temp = n >> (i*32);
-		temp &= 0xFFFFFFFF;
-		arr[i] = temp.to_ulong();
+		int limb = i/2;
+		arr[i] = (limb < BIGINT_LIMBS) ? (d[limb] >> (32*(i%2))) & 0xFFFFFFFF : 0;
 	}
 }
+bool BigInt::toWord(unsigned long long& val) const{
+	if(used > 1){
+		return false;
+	}
+	val = d[0];
+	return true;
+}
+
 std::string BigInt::toString() const
 {
-	return n.to_string<char, std::char_traits<char>, std::allocator<char> >();
+	return getN().to_string<char, std::char_traits<char>, std::allocator<char> >();
 }
 
 std::string BigInt::toHexString() const
 {
 	std::string response = "0x";
-	std::string nStr = n.to_string<char, std::char_traits<char>, std::allocator<char> >();
+	std::string nStr = getN().to_string<char, std::char_traits<char>, std::allocator<char> >();
 	int limit = nStr.length();
 	int halfword = 1;
 	
@@ -101,319 +150,157 @@ std::string BigInt::toHexString() const
 //Reference a particular bit at position pos.
 int BigInt::operator[](int pos) const{
 	if(pos >= 0 && pos < BIGINT_SIZE){
-		return n[pos];
+		return (d[pos/LIMB_BITS] >> (pos%LIMB_BITS)) & 1;
 	}
 	else{
 		return -1;
 	}
 }
 
-//Multiply two BigInts.
-BigInt BigInt::operator*(BigInt op){
-	BigInt response;
-	std::bitset<BIGINT_SIZE> answer;
-	std::bitset<BIGINT_SIZE> a = n;
-	
-	//If either n or op.n = 0, don't bother.
-	if(n.none() || op.n.none()){
-		return response;	
-	}
-	
-	for(unsigned int i = 0; i < op.n.size(); i++){
-		// If ith bit in op.n = 1, add response += n, and shift n << 1.
-		if(op.n.test(i)){
-			answer = add(answer, a);
-			a <<= 1;
-		}
-		// Else, shift n << 1.
-		else{
-			a <<= 1;
-		}
-	}//end for loop.
+//The two limbs as one native integer, and back.
+dlimb_t BigInt::wide() const{
+	return ((dlimb_t)d[1] << LIMB_BITS) | d[0];
+}
 
-	response = answer;
+BigInt BigInt::fromWide(dlimb_t x){
+	BigInt response;
+	response.d[0] = (limb_t)x;
+	response.d[1] = (limb_t)(x >> LIMB_BITS);
+	response.normalize();
 	return response;
 }
 
+//Multiply two BigInts.  The low 128 bits of the native product are exact, so
+//masking them to BIGINT_SIZE in fromWide() gives what a BIGINT_SIZE bit multiply
+//would.
+BigInt BigInt::operator*(BigInt op){
+	return fromWide(wide() * op.wide());
+}
+
 // Multiplication and assignment.
 BigInt& BigInt::operator*=(BigInt op){
-	BigInt response;
-	std::bitset<BIGINT_SIZE> answer;
-	
-	//If either n or op.n = 0, don't bother.
-	if(n.none() || op.n.none()){
-		n = 0x00;
-		return *this;	
+	*this = *this * op;
+	return *this;
+}
+
+// Square a BigInt: a product with itself.
+BigInt BigInt::sqr() const{
+	return fromWide(wide() * wide());
+}
+
+//Fused [a*b] mod m: one native multiply and one native division, with no BigInt
+//in between.
+BigInt mulmod(BigInt a, BigInt b, BigInt m){
+	dlimb_t mw = m.wide();
+	if(mw == 0){
+		return BigInt();
 	}
-	
-	for(unsigned int i = 0; i < op.n.size(); i++){
-		// If ith bit in op.n = 1, add response += n, and shift n << 1.
-		if(op.n.test(i)){
-			answer = add(answer, n);
-			n <<= 1;
-		}
-		// Else, shift n << 1.
-		else{
-			n <<= 1;
-		}
-	}//end for loop.
+	dlimb_t p = a.wide() * b.wide();
+	p &= ((dlimb_t)BIGINT_TOP_MASK << LIMB_BITS) | ~(limb_t)0;
+	//A one limb product and modulus take the 64 bit divide.
+	if((p >> LIMB_BITS) == 0 && (mw >> LIMB_BITS) == 0){
+		return BigInt::fromWide((limb_t)p % (limb_t)mw);
+	}
+	return BigInt::fromWide(p % mw);
+}
 
-	*this = answer;
-	return *this;
+// Fused a + b*c; the wrap at 128 bits is cut back to BIGINT_SIZE by fromWide().
+BigInt addmul(BigInt a, BigInt b, BigInt c){
+	return BigInt::fromWide(a.wide() + b.wide() * c.wide());
 }
 
-// Add two BigInts
+// Fused a - b*c, wrapping like operator-.
+BigInt submul(BigInt a, BigInt b, BigInt c){
+	return BigInt::fromWide(a.wide() - b.wide() * c.wide());
+}
+
+// Add two BigInts.  Any carry out of the top bit is lost.
 BigInt BigInt::operator+(BigInt op){
 	BigInt response;
-	response = add(n, op.n);
+	limbAdd(response.d, d, op.d, BIGINT_LIMBS);
+	response.normalize();
 	return response;	
 }
 
-// Compare two BigInts.  This code is dependent on BIGINT_SIZE = 96.
-bool BigInt::operator>=(BigInt op){
-	std::bitset<BIGINT_SIZE> opUpper, opMid, opLower, nUpper, nMid, nLower;
-	unsigned long opUppL, opMidL, opLowL, nUppL, nMidL, nLowL;
-	opUpper = op.n >> 64;
-	nUpper = n >> 64;
-	opUppL = opUpper.to_ulong();
-	nUppL = nUpper.to_ulong();
-	if(nUppL > opUppL){
-		return true;
+// Unsigned comparison: the longer value is larger, otherwise compare from the
+// top limb down.
+static int compare(const limb_t* a, int an, const limb_t* b, int bn){
+	if(an != bn){
+		return (an > bn) ? 1 : -1;
 	}
-	if(nUppL < opUppL){
-		return false;
-	}
-	//nUppL == opUppL
-	opMid = op.n >> 32;
-	opMid &= 0xFFFFFFFF;
-	nMid = n >> 32;
-	nMid &= 0xFFFFFFFF;
-	opMidL = opMid.to_ulong();
-	nMidL = nMid.to_ulong();
-	if(nMidL > opMidL){
-		return true;
-	}
-	if(nMidL < opMidL){
-		return false;
-	}
-	//nMidL == opMidL
-	opLower = op.n;
-	opLower&= 0xFFFFFFFF;
-	nLower = n;
-	nLower &= 0xFFFFFFFF;
-	opLowL = opLower.to_ulong();
-	nLowL = nLower.to_ulong();
-	if(nLowL >= opLowL){
-		return true;
-	}
-	return false;
+	return limbCmp(a, b, an);
+}
+
+bool BigInt::operator>=(BigInt op){
+	return compare(d, used, op.d, op.used) >= 0;
 }
 
-//This code is dependent on BIGINT_SIZE = 96.
 bool BigInt::operator>(BigInt op){
-	std::bitset<BIGINT_SIZE> opUpper, opMid, opLower, nUpper, nMid, nLower;
-	unsigned long opUppL, opMidL, opLowL, nUppL, nMidL, nLowL;
-	opUpper = op.n >> 64;
-	nUpper = n >> 64;
-	opUppL = opUpper.to_ulong();
-	nUppL = nUpper.to_ulong();
-	if(nUppL > opUppL){
-		return true;
-	}
-	if(nUppL < opUppL){
-		return false;
-	}
-	//nUppL == opUppL
-	opMid = op.n >> 32;
-	opMid &= 0xFFFFFFFF;
-	nMid = n >> 32;
-	nMid &= 0xFFFFFFFF;
-	opMidL = opMid.to_ulong();
-	nMidL = nMid.to_ulong();
-	if(nMidL > opMidL){
-		return true;
-	}
-	if(nMidL < opMidL){
-		return false;
-	}
-	//nMidL == opMidL	
-	opLower = op.n;
-	 opLower&= 0xFFFFFFFF;
-	nLower = n;
-	nLower &= 0xFFFFFFFF;
-	opLowL = opLower.to_ulong();
-	nLowL = nLower.to_ulong();
-	if(nLowL > opLowL){
-		return true;
-	}
-	return false;
+	return compare(d, used, op.d, op.used) > 0;
 }
 
-//This is very much dependent on BIGINT_SIZE.
-//If the size != 96, this code will have to change.
 bool BigInt::operator<=(BigInt op){
-	std::bitset<BIGINT_SIZE> opUpper, opMid, opLower, nUpper, nMid, nLower;
-	unsigned long opUppL, opMidL, opLowL, nUppL, nMidL, nLowL;
-	opUpper = op.n >> 64;
-	nUpper = n >> 64;
-	opUppL = opUpper.to_ulong();
-	nUppL = nUpper.to_ulong();
-	if(nUppL < opUppL){
-		return true;
-	}
-	if(nUppL > opUppL){
-		return false;
-	}
-	//nUppL == opUppL
-	opMid = op.n >> 32;
-	opMid &= 0xFFFFFFFF;
-	nMid = n >>32;
-	nMid &= 0xFFFFFFFF;
-	opMidL = opMid.to_ulong();
-	nMidL = nMid.to_ulong();
-	if(nMidL < opMidL){
-		return true;
-	}
-	if(nMidL > opMidL){
-		return false;
-	}
-	//nMidL == opMidL
-	opLower = op.n;
-	 opLower&= 0xFFFFFFFF;
-	nLower = n;
-	nLower &= 0xFFFFFFFF;
-	opLowL = opLower.to_ulong();
-	nLowL = nLower.to_ulong();
-	if(nLowL <= opLowL){
-		return true;
-	}
-	return false;
+	return compare(d, used, op.d, op.used) <= 0;
 }
 
-//Depends on BIGINT_SIZE
 bool BigInt::operator<(BigInt op){
-	std::bitset<BIGINT_SIZE> opUpper, opMid, opLower, nUpper, nMid, nLower;
-	unsigned long opUppL, opMidL, opLowL, nUppL, nMidL, nLowL;
-	opUpper = op.n >> 64;
-	nUpper = n >> 64;
-	
-	opUppL = opUpper.to_ulong();
-	nUppL = nUpper.to_ulong();
-	if(nUppL < opUppL){
-		return true;
-	}
-	if(nUppL > opUppL){
-		return false;
+	return compare(d, used, op.d, op.used) < 0;
+}
+
+// Divides a by b, both non-zero, with native division: 64 bit when both fit in
+// one limb, 128 bit otherwise.
+static void divide(BigInt* q, BigInt* r, const limb_t* a, int an, const limb_t* b, int bn){
+	std::bitset<BIGINT_SIZE> qb, rb;
+	if(an <= 1 && bn <= 1){
+		qb = a[0] / b[0];
+		rb = a[0] % b[0];
 	}
-	//nUppL == opUppL
-	opMid = op.n >> 32;
-	opMid &= 0xFFFFFFFF;
-	
-	nMid = n >>32;
-	nMid &= 0xFFFFFFFF;
-	
-	opMidL = opMid.to_ulong();
-	nMidL = nMid.to_ulong();
-	if(nMidL < opMidL){
-		return true;
+	else{
+		dlimb_t x = ((dlimb_t)a[1] << LIMB_BITS) | a[0];
+		dlimb_t y = ((dlimb_t)(bn > 1 ? b[1] : 0) << LIMB_BITS) | b[0];
+		dlimb_t qq = x / y;
+		dlimb_t rr = x - qq*y;
+		qb = (limb_t)(qq >> LIMB_BITS);
+		qb <<= LIMB_BITS;
+		qb |= (limb_t)qq;
+		rb = (limb_t)(rr >> LIMB_BITS);
+		rb <<= LIMB_BITS;
+		rb |= (limb_t)rr;
 	}
-	if(nMidL > opMidL){
-		return false;
+	if(q){
+		*q = qb;
 	}
-	//nMidL == opMidL
-	opLower = op.n;
-	opLower&= 0xFFFFFFFF;
-	nLower = n;
-	nLower &= 0xFFFFFFFF;
-	opLowL = opLower.to_ulong();
-	nLowL = nLower.to_ulong();
-	if(nLowL < opLowL){
-		return true;
+	if(r){
+		*r = rb;
 	}
-	return false;
 }
 
 // Divide two BigInts.  Any remainder is discarded. *this/dvsr.
 BigInt BigInt::operator/(BigInt divisor){
 	BigInt response;
-	BigInt quotient;
-	BigInt dividend = *this;
-	BigInt origDivisor = divisor;
-	int idx = BIGINT_SIZE -1;
 	
-	if(dividend<divisor){
-		response = 0;
+	if(divisor.used == 0 || *this < divisor){
+		return response;
 	}
-	else{
-		//Find the leftmost bit in dividend.
-		while(!dividend[idx]){
-			idx--;
-		}
-		//Left align the divisor with the dividend.
-		while(!divisor[idx]){
-			divisor <<= 1;
-		}
-		//Perform binary division.
-		do{
-			if(dividend >= divisor){
-				dividend = dividend-divisor;
-				quotient <<= 1;
-				quotient |= 0x01;
-			}
-			else{
-				quotient <<= 1;
-			}
-			divisor >>= 1;
-		}while(divisor >= origDivisor);
-			
-		response = quotient;	
-	}
-
+	divide(&response, 0, d, used, divisor.d, divisor.used);
 	return response;
 }
 
 bool BigInt::operator==(BigInt op){
-	return (n==op.n);
+	return used == op.used && limbCmp(d, op.d, used) == 0;
 }
 
 // Find the modulo when dividing two BigInts. *this/divisor.
 BigInt BigInt::operator%(BigInt divisor){
 	BigInt response;
-	BigInt quotient;
-	BigInt dividend = *this;
-	BigInt origDivisor = divisor;
-	int idx = BIGINT_SIZE -1;
 		
 	if(divisor.isZero()){
-		response = 0;
+		return response;
 	}
-	else if(dividend<divisor){
-		response = dividend;
-	}
-	else{
-		//Find the leftmost bit in dividend.
-		while(!dividend[idx] ){
-			idx--;
-		}
-		//Left align the divisor with the dividend.
-		while(!divisor[idx]){
-			divisor <<= 1;
-		}
-		//Perform binary division.
-		do{
-			if(dividend >= divisor){
-				dividend = dividend-divisor;
-				quotient <<= 1;
-				quotient |= 0x01;
-			}
-			else{
-				quotient <<= 1;
-			}
-			divisor >>= 1;
-		}while(dividend >= origDivisor);
-			
-		response = dividend;	
+	if(*this < divisor){
+		return *this;
 	}
+	divide(0, &response, d, used, divisor.d, divisor.used);
 	return response;
 }
 
@@ -421,31 +308,60 @@ BigInt BigInt::operator%(BigInt divisor){
 
 // Shift left
 BigInt& BigInt::operator<<=(int shift){
-	n <<= shift;
+	if(shift >= BIGINT_SIZE){
+		d[0] = 0;
+		d[1] = 0;
+	}
+	else if(shift > 0){
+		dlimb_t x = ((dlimb_t)d[1] << LIMB_BITS) | d[0];
+		x <<= shift;
+		d[0] = (limb_t)x;
+		d[1] = (limb_t)(x >> LIMB_BITS);
+	}
+	normalize();
 	return *this;
 }
 
 // Shift right
 BigInt& BigInt::operator>>=(int shift){
-	n>>=shift;
+	if(shift >= BIGINT_SIZE){
+		d[0] = 0;
+		d[1] = 0;
+	}
+	else if(shift > 0){
+		dlimb_t x = ((dlimb_t)d[1] << LIMB_BITS) | d[0];
+		x >>= shift;
+		d[0] = (limb_t)x;
+		d[1] = (limb_t)(x >> LIMB_BITS);
+	}
+	normalize();
 	return *this;
 }
 
 // Bitwise OR with assignment.
 BigInt& BigInt::operator|=(BigInt op){
-	n|=op.n;
+	for(int i=0; i<BIGINT_LIMBS; i++){
+		d[i] |= op.d[i];
+	}
+	normalize();
 	return *this;
 }
 
 // Bitwise AND with assignment.
 BigInt& BigInt::operator&=(BigInt op){
-	n&=op.n;
+	for(int i=0; i<BIGINT_LIMBS; i++){
+		d[i] &= op.d[i];
+	}
+	normalize();
 	return *this;
 }
 
 // Flip every bit.
 BigInt& BigInt::flip(){
-	n.flip();
+	for(int i=0; i<BIGINT_LIMBS; i++){
+		d[i] = ~d[i];
+	}
+	normalize();
 	return *this;
 }
 
@@ -453,7 +369,8 @@ BigInt& BigInt::flip(){
 // Subtract two BigInts.  Won't throw an error if n<op.n.
 BigInt BigInt::operator-(BigInt op){
 	BigInt response;
-	response = subtract(n, op.n);
+	limbSub(response.d, d, op.d, BIGINT_LIMBS);
+	response.normalize();
 	return response;
 }
 	
@@ -469,51 +386,48 @@ BigInt BigInt::exp(int y){
 	return response;
 }
 
-// Calculate this^y using fast exponentiation.
+// Calculate this^y using fast exponentiation, from the exponent's top bit.
 BigInt BigInt::exp(BigInt y){
 	BigInt result;
-	std::bitset<BIGINT_SIZE> bity;
 	result = 1;
-	bity = y.n;
-	for(int i=BIGINT_SIZE-1; i>=0; i--){
-		if(bity.test(i)){
-			result = result*result;
-			result = result*n;
-		}
-		else{
-			result = result*result;
+	for(int i=y.bitLength()-1; i>=0; i--){
+		result = result.sqr();
+		if(y[i]){
+			result = result * *this;
 		}
 	}
 	return result;
 }
 std::bitset<BIGINT_SIZE> BigInt::getN() const {
-	return n;
+	std::bitset<BIGINT_SIZE> response(d[1]);
+	response <<= LIMB_BITS;
+	response |= std::bitset<BIGINT_SIZE>(d[0]);
+	return response;
 }
 
 //x^y mod m using fast exponentiation.
 BigInt modPow(BigInt x, BigInt y, BigInt m){
 	
 	BigInt result;
-	std::bitset<BIGINT_SIZE> bity;
-	int startIdx = BIGINT_SIZE - 1;
+	unsigned long long mw, xw = 0;
+	if(m.toWord(mw) && mw != 0){
+		unsigned long w[3];
+		limb_t e[2];
+		y.toULong(w, 3);
+		e[0] = ((limb_t)w[1] << 32) | w[0];
+		e[1] = w[2];
+		if(!x.toWord(xw)){
+			(x % m).toWord(xw);
+		}
+		return BigInt(std::bitset<BIGINT_SIZE>(wordPowMod(xw, e, 2, mw)));
+	}
 	result = 1;
-	bity = y.getN();
-	
 	
-	//ignore leading 0's and check for y==0.
-	while((startIdx>=0) && (!(bity.test(startIdx)))){
-		startIdx--;
-	}
-	for(int i=startIdx; i>=0; i--){
-		if(bity.test(i)){
-			result = result*result;
-			result = result % m;
-			result = result*x.getN();
-			result = result % m;
-		}
-		else{
-			result = result*result;
-			result = result % m;
+	//Start at the exponent's top bit; y == 0 gives 1.
+	for(int i=y.bitLength()-1; i>=0; i--){
+		result = mulmod(result, result, m);
+		if(y[i]){
+			result = mulmod(result, x, m);
 		}
 	}
 	return result;
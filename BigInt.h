@@ -2,16 +2,21 @@
 #define BIGINT_H_
 #include <string>
 #include <bitset>
+#include "Limb.h"
 
 namespace RSAUtil
 {
 	#define BIGINT_SIZE 96
+	//Number of limbs holding BIGINT_SIZE bits; the top one is only partly used.
+	#define BIGINT_LIMBS ((BIGINT_SIZE + LIMB_BITS - 1) / LIMB_BITS)
 	
 	/*
 	 * **********************************************************************************
-	 * A class for representing 64 bit integers.  This is a wrapper class for a
-	 * std::bitset<BIGINT_SIZE>.  It provides common operators for dealing with
-	 * integers.  
+	 * A class for representing 64 bit integers.  The BIGINT_SIZE bits are held in
+	 * 64 bit limbs together with the number of significant limbs, so arithmetic
+	 * only touches the words a value actually uses; std::bitset<BIGINT_SIZE> is
+	 * still accepted and returned (see getN()).  It provides common operators for
+	 * dealing with integers.  
 	 *  
 	 * @class: BigInt
 	 * @namespace: RSAUtil
@@ -25,8 +30,22 @@ namespace RSAUtil
 class BigInt
 {
 private:
-	//The BIGINT_SIZE bit number represented by this class.
-	std::bitset<BIGINT_SIZE> n;	
+	//The BIGINT_SIZE bit number represented by this class, least significant limb
+	//first.  Bits at and above BIGINT_SIZE are always zero.
+	limb_t d[BIGINT_LIMBS];
+	//Number of significant limbs; d[used..] are zero.
+	int used;
+
+	//Clears the bits above BIGINT_SIZE and recomputes used.
+	void normalize();
+
+	//The value as one native integer, and back.
+	dlimb_t wide() const;
+	static BigInt fromWide(dlimb_t);
+
+	friend BigInt mulmod(BigInt, BigInt, BigInt);
+	friend BigInt addmul(BigInt, BigInt, BigInt);
+	friend BigInt submul(BigInt, BigInt, BigInt);
 	
 	
 public:
@@ -65,7 +84,8 @@ public:
 	
 	/*
 	 * ******************************************************************************
-	 * Overloaded multiplication operator.  Any carry-out is discarded.
+	 * Overloaded multiplication operator.  Any carry-out is discarded.  See mulmod,
+	 * addmul and submul for a product used in a modulus, sum or difference.
 	 * @parameter BigInt: Second operand in multiplication calculation.
 	 * @returns BigInt: The result of multiplying this BigInt with the given BigInt.
 	 * ******************************************************************************
@@ -81,6 +101,14 @@ public:
 	 * *******************************************************************************
 	 */
 	BigInt& operator*=(BigInt);
+	/*
+	 * ******************************************************************************
+	 * sqr.	Squares this BigInt.  Any carry-out is discarded.  exp() uses it for
+	 * 		every squaring.
+	 * @returns BigInt: The square of this BigInt.
+	 * ******************************************************************************
+	 */
+	BigInt sqr() const;
 	
 	/*
 	 * *******************************************************************************
@@ -236,6 +264,22 @@ public:
 	 * *********************************************************************************
 	 */
 	bool isZero();
+
+	/*
+	 * ********************************************************************************
+	 * bitLength.	Number of bits up to and including the highest set bit (0 for
+	 * 				zero), found with a count of leading zeros.
+	 * *********************************************************************************
+	 */
+	int bitLength() const;
+
+	/*
+	 * ********************************************************************************
+	 * lowestSetBit.	Index of the lowest set bit, found with a count of trailing
+	 * 					zeros; -1 for zero.
+	 * *********************************************************************************
+	 */
+	int lowestSetBit() const;
 	
 	/*
 	 * *********************************************************************************
@@ -264,6 +308,16 @@ public:
 	 */
 	void toULong(unsigned long*, int) const;				
 
+	/*
+	 * *********************************************************************************
+	 * toWord.		Fetch this BigInt as a native 64 bit integer.
+	 * @parameter unsigned long long&:	Receives the value.
+	 * @returns bool:	False, leaving the parameter alone, if the value needs more
+	 * 					than 64 bits (which includes every negative value).
+	 * *********************************************************************************
+	 */
+	bool toWord(unsigned long long&) const;
+
 
 
 	
@@ -272,7 +326,8 @@ public:
 	/*
 	 * *********************************************************************************
 	 * modPow.	Performs modular exponentiation.  If the three parameters are a, b, m
-	 * 		(in that order) then this function returns [a^b] mod m.
+	 * 		(in that order) then this function returns [a^b] mod m.  A modulus
+	 * 		that fits in 64 bits is handled with native arithmetic.
 	 * @parameter BigInt:	The first operand.
 	 * @parameter BigInt:	The exponent.
 	 * @parameter BigInt:	The modulus.
@@ -280,6 +335,23 @@ public:
 	 * *********************************************************************************
 	 */
 	BigInt modPow(BigInt, BigInt, BigInt);
+
+	/*
+	 * *********************************************************************************
+	 * Fused products: each forms the product of two BigInts natively and uses it in
+	 * the same step, without a BigInt temporary for the product.  The product wraps
+	 * at BIGINT_SIZE bits as with operator*.
+	 *
+	 * mulmod.	[a*b] mod m, or 0 if m is 0, as for operator%.  modPow() uses it
+	 * 			for every step.
+	 * addmul.	a + b*c.  Any carry-out is discarded.
+	 * submul.	a - b*c, wrapping like operator-.  modInverse() uses it for every
+	 * 			step.
+	 * *********************************************************************************
+	 */
+	BigInt mulmod(BigInt, BigInt, BigInt);
+	BigInt addmul(BigInt, BigInt, BigInt);
+	BigInt submul(BigInt, BigInt, BigInt);
 	
 	/*
 	 * *********************************************************************************
@@ -0,0 +1,915 @@
+#include "BigNum.h"
+#include "Montgomery.h"
+#include "Tuning.h"
+#include <string>
+#include <cstring>
+#include <bitset>
+
+namespace RSAUtil
+{
+
+/*
+ * A class for handling integers of any size.
+ * Implemented via an array of 64 bit limbs with a small inline buffer.
+*/
+void BigNum::init(LimbAllocator* a){
+	d = local;
+	used = 0;
+	cap = BIGNUM_INLINE_LIMBS;
+	alloc = a;
+}
+
+BigNum::BigNum()
+{
+	init(defaultAllocator());
+}
+
+BigNum::BigNum(unsigned long long val)
+{
+	init(defaultAllocator());
+	d[0] = val;
+	used = (val != 0);
+}
+
+BigNum::BigNum(const BigInt& val)
+{
+	unsigned long words[3];
+	init(defaultAllocator());
+	val.toULong(words, 3);
+	d[0] = ((limb_t)words[1] << 32) | words[0];
+	d[1] = words[2];
+	used = 2;
+	trim();
+}
+
+BigNum::BigNum(LimbAllocator& a)
+{
+	init(&a);
+}
+
+BigNum::BigNum(const BigNum& other)
+{
+	init(other.alloc->isScoped() ? defaultAllocator() : other.alloc);
+	assign(other);
+}
+
+BigNum::BigNum(BigNum&& other)
+{
+	init(other.alloc->isScoped() ? defaultAllocator() : other.alloc);
+	//Steal spilled storage unless it lives in an arena.
+	if(other.isSpilled() && other.alloc == alloc){
+		d = other.d;
+		cap = other.cap;
+		used = other.used;
+		other.init(other.alloc);
+	}
+	else{
+		assign(other);
+	}
+}
+
+BigNum::~BigNum()
+{
+	if(isSpilled()){
+		alloc->release(d, cap);
+	}
+}
+
+BigNum& BigNum::operator=(const BigNum& other){
+	if(this != &other){
+		assign(other);
+	}
+	return *this;
+}
+
+BigNum& BigNum::operator=(BigNum&& other){
+	if(this == &other){
+		return *this;
+	}
+	if(other.isSpilled() && other.alloc == alloc){
+		if(isSpilled()){
+			alloc->release(d, cap);
+		}
+		d = other.d;
+		cap = other.cap;
+		used = other.used;
+		other.init(other.alloc);
+	}
+	else{
+		assign(other);
+	}
+	return *this;
+}
+
+bool BigNum::isSpilled() const{
+	return d != local;
+}
+
+//Make room for n limbs.  The current value is kept only if preserve is set.
+void BigNum::grow(int n, bool preserve){
+	if(n <= cap){
+		return;
+	}
+	int newCap = (n > 2*cap) ? n : 2*cap;
+	limb_t* p = alloc->allocate(newCap);
+	if(preserve){
+		std::memcpy(p, d, used*sizeof(limb_t));
+	}
+	if(isSpilled()){
+		alloc->release(d, cap);
+	}
+	d = p;
+	cap = newCap;
+}
+
+void BigNum::trim(){
+	used = limbLength(d, used);
+}
+
+void BigNum::assign(const BigNum& other){
+	grow(other.used, false);
+	std::memcpy(d, other.d, other.used*sizeof(limb_t));
+	used = other.used;
+}
+
+void BigNum::reserve(int n){
+	grow(n, true);
+}
+
+void BigNum::swap(BigNum& other){
+	if(isSpilled() && other.isSpilled() && alloc == other.alloc){
+		limb_t* td = d;
+		int tc = cap;
+		int tu = used;
+		d = other.d;
+		cap = other.cap;
+		used = other.used;
+		other.d = td;
+		other.cap = tc;
+		other.used = tu;
+		return;
+	}
+	//Exchange through whichever buffer is big enough for both values.
+	int n = (used > other.used) ? used : other.used;
+	reserve(n);
+	other.reserve(n);
+	for(int i=0; i<n; i++){
+		limb_t t = (i < used) ? d[i] : 0;
+		d[i] = (i < other.used) ? other.d[i] : 0;
+		other.d[i] = t;
+	}
+	int tu = used;
+	used = other.used;
+	other.used = tu;
+}
+
+int BigNum::size() const{
+	return used;
+}
+
+limb_t BigNum::limb(int i) const{
+	return (i >= 0 && i < used) ? d[i] : 0;
+}
+
+const limb_t* BigNum::limbs() const{
+	return d;
+}
+
+void BigNum::setLimbs(const limb_t* src, int n){
+	grow(n, false);
+	std::memmove(d, src, n*sizeof(limb_t));
+	used = n;
+	trim();
+}
+
+int BigNum::operator[](int pos) const{
+	if(pos < 0){
+		return -1;
+	}
+	return (int)((limb(pos / LIMB_BITS) >> (pos % LIMB_BITS)) & 1);
+}
+
+int BigNum::bitLength() const{
+	if(used == 0){
+		return 0;
+	}
+	return used*LIMB_BITS - __builtin_clzll(d[used-1]);
+}
+
+bool BigNum::isZero() const{
+	return used == 0;
+}
+
+bool BigNum::isOdd() const{
+	return used > 0 && (d[0] & 1);
+}
+
+int BigNum::compare(const BigNum& op) const{
+	if(used != op.used){
+		return (used > op.used) ? 1 : -1;
+	}
+	return limbCmp(d, op.d, used);
+}
+
+bool BigNum::operator==(const BigNum& op) const{
+	return compare(op) == 0;
+}
+
+bool BigNum::operator!=(const BigNum& op) const{
+	return compare(op) != 0;
+}
+
+bool BigNum::operator<(const BigNum& op) const{
+	return compare(op) < 0;
+}
+
+bool BigNum::operator<=(const BigNum& op) const{
+	return compare(op) <= 0;
+}
+
+bool BigNum::operator>(const BigNum& op) const{
+	return compare(op) > 0;
+}
+
+bool BigNum::operator>=(const BigNum& op) const{
+	return compare(op) >= 0;
+}
+
+// r = a + b.
+void BigNum::add(BigNum& r, const BigNum& a, const BigNum& b){
+	const BigNum* big = (a.used >= b.used) ? &a : &b;
+	const BigNum* small = (a.used >= b.used) ? &b : &a;
+	int bn = big->used;
+	int sn = small->used;
+	//Sizes first: r may be a or b, and growing r must not lose their limbs.
+	r.reserve(bn + 1);
+	limb_t carry = limbAdd(r.d, big->d, small->d, sn);
+	carry = limbAdd1(r.d + sn, big->d + sn, bn - sn, carry);
+	r.d[bn] = carry;
+	r.used = bn + 1;
+	r.trim();
+}
+
+// r = a - b, or 0 if b > a.
+void BigNum::sub(BigNum& r, const BigNum& a, const BigNum& b){
+	if(a.compare(b) <= 0){
+		r.used = 0;
+		return;
+	}
+	int an = a.used;
+	int bn = b.used;
+	r.reserve(an);
+	limb_t borrow = limbSub(r.d, a.d, b.d, bn);
+	limbSub1(r.d + bn, a.d + bn, an - bn, borrow);
+	r.used = an;
+	r.trim();
+}
+
+// r = a * b.
+void BigNum::mul(BigNum& r, const BigNum& a, const BigNum& b){
+	int an = a.used;
+	int bn = b.used;
+	if(an == 0 || bn == 0){
+		r.used = 0;
+		return;
+	}
+	r.reserve(an + bn);
+	if(&r == &a || &r == &b){
+		//limbMul cannot write over its inputs; go through the arena.
+		LimbArena& arena = scratchArena();
+		ArenaScope scope(arena);
+		limb_t* t = arena.take(an + bn);
+		limbMul(t, a.d, an, b.d, bn);
+		std::memcpy(r.d, t, (an + bn)*sizeof(limb_t));
+	}
+	else{
+		limbMul(r.d, a.d, an, b.d, bn);
+	}
+	r.used = an + bn;
+	r.trim();
+}
+
+void BigNum::sqr(BigNum& r, const BigNum& a){
+	int an = a.used;
+	if(an == 0){
+		r.used = 0;
+		return;
+	}
+	r.reserve(2*an);
+	if(&r == &a){
+		LimbArena& arena = scratchArena();
+		ArenaScope scope(arena);
+		limb_t* t = arena.take(2*an);
+		limbSqr(t, a.d, an);
+		std::memcpy(r.d, t, 2*an*sizeof(limb_t));
+	}
+	else{
+		limbSqr(r.d, a.d, an);
+	}
+	r.used = 2*an;
+	r.trim();
+}
+
+// q = a / b, r = a % b.
+void BigNum::divMod(BigNum* q, BigNum* r, const BigNum& a, const BigNum& b){
+	int an = a.used;
+	int bn = b.used;
+	if(bn == 0){
+		//Division by 0 gives 0.
+		if(q){
+			q->used = 0;
+		}
+		if(r){
+			r->used = 0;
+		}
+		return;
+	}
+	if(an < bn){
+		//The remainder first, in case the quotient is a.
+		if(r && r != &a){
+			r->assign(a);
+		}
+		if(q){
+			q->used = 0;
+		}
+		return;
+	}
+	//Size the outputs before limbDivRem opens its own arena scope.
+	if(q){
+		q->reserve(an - bn + 1);
+	}
+	if(r){
+		r->reserve(bn);
+	}
+	limbDivRem(q ? q->d : 0, r ? r->d : 0, a.d, an, b.d, bn);
+	if(q){
+		q->used = an - bn + 1;
+		q->trim();
+	}
+	if(r){
+		r->used = bn;
+		r->trim();
+	}
+}
+
+// r = a + w.
+void BigNum::addWord(BigNum& r, const BigNum& a, limb_t w){
+	int an = a.used;
+	r.reserve(an + 1);
+	r.d[an] = limbAdd1(r.d, a.d, an, w);
+	r.used = an + 1;
+	r.trim();
+}
+
+// r = a - w, or 0 if w > a.
+void BigNum::subWord(BigNum& r, const BigNum& a, limb_t w){
+	int an = a.used;
+	if(an == 0 || (an == 1 && a.d[0] <= w)){
+		r.used = 0;
+		return;
+	}
+	r.reserve(an);
+	limbSub1(r.d, a.d, an, w);
+	r.used = an;
+	r.trim();
+}
+
+// r = a * w.
+void BigNum::mulWord(BigNum& r, const BigNum& a, limb_t w){
+	int an = a.used;
+	if(an == 0 || w == 0){
+		r.used = 0;
+		return;
+	}
+	r.reserve(an + 1);
+	r.d[an] = limbMul1(r.d, a.d, an, w);
+	r.used = an + 1;
+	r.trim();
+}
+
+// q = a / w; returns a % w.
+limb_t BigNum::divModWord(BigNum* q, const BigNum& a, limb_t w){
+	if(w == 0){
+		if(q){
+			q->used = 0;
+		}
+		return 0;
+	}
+	int an = a.used;
+	if(!q){
+		return limbDivRem1(0, a.d, an, w);
+	}
+	q->reserve(an);
+	limb_t rem = limbDivRem1(q->d, a.d, an, w);
+	q->used = an;
+	q->trim();
+	return rem;
+}
+
+BigNum BigNum::operator+(const BigNum& op) const{
+	BigNum response;
+	add(response, *this, op);
+	return response;
+}
+
+BigNum BigNum::operator-(const BigNum& op) const{
+	BigNum response;
+	sub(response, *this, op);
+	return response;
+}
+
+BigNum BigNum::operator*(const BigNum& op) const{
+	BigNum response;
+	mul(response, *this, op);
+	return response;
+}
+
+BigNum BigNum::operator/(const BigNum& op) const{
+	BigNum response;
+	divMod(&response, 0, *this, op);
+	return response;
+}
+
+BigNum BigNum::operator%(const BigNum& op) const{
+	BigNum response;
+	divMod(0, &response, *this, op);
+	return response;
+}
+
+BigNum& BigNum::operator+=(const BigNum& op){
+	add(*this, *this, op);
+	return *this;
+}
+
+BigNum& BigNum::operator-=(const BigNum& op){
+	sub(*this, *this, op);
+	return *this;
+}
+
+BigNum& BigNum::operator*=(const BigNum& op){
+	mul(*this, *this, op);
+	return *this;
+}
+
+BigNum& BigNum::operator/=(const BigNum& op){
+	divMod(this, 0, *this, op);
+	return *this;
+}
+
+BigNum& BigNum::operator%=(const BigNum& op){
+	divMod(0, this, *this, op);
+	return *this;
+}
+
+BigNum BigNum::operator+(limb_t w) const{
+	BigNum response;
+	addWord(response, *this, w);
+	return response;
+}
+
+BigNum BigNum::operator-(limb_t w) const{
+	BigNum response;
+	subWord(response, *this, w);
+	return response;
+}
+
+BigNum BigNum::operator*(limb_t w) const{
+	BigNum response;
+	mulWord(response, *this, w);
+	return response;
+}
+
+BigNum BigNum::operator/(limb_t w) const{
+	BigNum response;
+	divModWord(&response, *this, w);
+	return response;
+}
+
+BigNum BigNum::operator%(limb_t w) const{
+	return BigNum(divModWord(0, *this, w));
+}
+
+BigNum& BigNum::operator+=(limb_t w){
+	addWord(*this, *this, w);
+	return *this;
+}
+
+BigNum& BigNum::operator-=(limb_t w){
+	subWord(*this, *this, w);
+	return *this;
+}
+
+BigNum& BigNum::operator*=(limb_t w){
+	mulWord(*this, *this, w);
+	return *this;
+}
+
+BigNum& BigNum::operator/=(limb_t w){
+	divModWord(this, *this, w);
+	return *this;
+}
+
+BigNum& BigNum::operator%=(limb_t w){
+	limb_t rem = divModWord(0, *this, w);
+	used = 0;
+	if(rem){
+		d[0] = rem;
+		used = 1;
+	}
+	return *this;
+}
+
+BigNum& BigNum::operator<<=(int shift){
+	if(used == 0 || shift <= 0){
+		return *this;
+	}
+	int words = shift / LIMB_BITS;
+	int bits = shift % LIMB_BITS;
+	reserve(used + words + 1);
+	d[used + words] = limbShl(d + words, d, used, bits);
+	std::memset(d, 0, words*sizeof(limb_t));
+	used += words + 1;
+	trim();
+	return *this;
+}
+
+BigNum& BigNum::operator>>=(int shift){
+	if(shift <= 0){
+		return *this;
+	}
+	int words = shift / LIMB_BITS;
+	if(words >= used){
+		used = 0;
+		return *this;
+	}
+	limbShr(d, d + words, used - words, shift % LIMB_BITS);
+	used -= words;
+	trim();
+	return *this;
+}
+
+BigNum BigNum::operator<<(int shift) const{
+	BigNum response(*this);
+	response <<= shift;
+	return response;
+}
+
+BigNum BigNum::operator>>(int shift) const{
+	BigNum response(*this);
+	response >>= shift;
+	return response;
+}
+
+std::string BigNum::toHexString() const{
+	static const char digits[] = "0123456789ABCDEF";
+	std::string response = "0x";
+
+	if(used == 0){
+		return response + "00";
+	}
+	//Print whole 16 bit halfwords, highest first, each followed by a space.
+	int halfwords = (bitLength() + 15) / 16;
+	for(int h=halfwords-1; h>=0; h--){
+		limb_t hw = (d[h/4] >> ((h%4)*16)) & 0xFFFF;
+		for(int shift=12; shift>=0; shift-=4){
+			response += digits[(hw >> shift) & 0xF];
+		}
+		response += " ";
+	}
+	return response;
+}
+
+std::string BigNum::toDecString() const{
+	//10^19 is the largest power of ten that fits in a limb.
+	const limb_t chunk = 10000000000000000000ULL;
+	std::string response;
+
+	if(used == 0){
+		return "0";
+	}
+	LimbArena& arena = scratchArena();
+	ArenaScope scope(arena);
+	limb_t* t = arena.take(used);
+	int n = used;
+	std::memcpy(t, d, n*sizeof(limb_t));
+	while(n > 0){
+		limb_t rem = limbDivRem1(t, t, n, chunk);
+		n = limbLength(t, n);
+		for(int i=0; i<19 && (n > 0 || rem != 0); i++){
+			response += (char)('0' + rem % 10);
+			rem /= 10;
+		}
+	}
+	return std::string(response.rbegin(), response.rend());
+}
+
+BigInt BigNum::toBigInt() const{
+	std::bitset<BIGINT_SIZE> hi(limb(1));
+	std::bitset<BIGINT_SIZE> lo(limb(0));
+	hi <<= LIMB_BITS;
+	return BigInt(hi | lo);
+}
+
+BigNum BigNum::fromHex(const std::string& str){
+	BigNum response;
+	size_t start = 0;
+
+	if(str.size() >= 2 && str[0] == '0' && (str[1] == 'x' || str[1] == 'X')){
+		start = 2;
+	}
+	int digitCount = 0;
+	for(size_t i=start; i<str.size(); i++){
+		if(str[i] != ' '){
+			digitCount++;
+		}
+	}
+	response.grow((digitCount + 15) / 16, false);
+	std::memset(response.d, 0, response.cap*sizeof(limb_t));
+	//Fill from the least significant digit up.
+	int pos = 0;
+	for(size_t i=str.size(); i>start; i--){
+		char c = str[i-1];
+		limb_t v;
+		if(c >= '0' && c <= '9'){
+			v = c - '0';
+		}
+		else if(c >= 'a' && c <= 'f'){
+			v = c - 'a' + 10;
+		}
+		else if(c >= 'A' && c <= 'F'){
+			v = c - 'A' + 10;
+		}
+		else{
+			continue;
+		}
+		response.d[pos/16] |= v << ((pos%16)*4);
+		pos++;
+	}
+	response.used = (pos + 15) / 16;
+	response.trim();
+	return response;
+}
+
+//Digits are gathered 19 at a time, the most that fit in a limb, so each limb's
+//worth costs one pass of mulWord and addWord rather than one per digit.
+BigNum BigNum::fromDec(const std::string& str){
+	BigNum response;
+	limb_t chunk = 0, scale = 1;
+	for(size_t i=0; i<str.size(); i++){
+		if(str[i] < '0' || str[i] > '9'){
+			continue;
+		}
+		chunk = chunk*10 + (str[i] - '0');
+		scale *= 10;
+		if(scale == 10000000000000000000ULL){
+			mulWord(response, response, scale);
+			addWord(response, response, chunk);
+			chunk = 0;
+			scale = 1;
+		}
+	}
+	if(scale > 1){
+		mulWord(response, response, scale);
+		addWord(response, response, chunk);
+	}
+	return response;
+}
+
+int expWindowBits(int ebits){
+	const Tuning& tuning = Tuning::current();
+	int k = 1;
+	for(int w=2; w<=TUNING_MAX_WINDOW; w++){
+		if(ebits > tuning.windowAbove[w]){
+			k = w;
+		}
+	}
+	return k;
+}
+
+// r = a*b mod m for mn-limb operands, with a 2mn-limb product buffer.
+static void mulMod(limb_t* r, const limb_t* a, const limb_t* b, const limb_t* m, int mn,
+		limb_t* prod){
+	limbMul(prod, a, mn, b, mn);
+	limbDivRem(0, r, prod, 2*mn, m, mn);
+}
+
+// r = a^2 mod m, as mulMod.
+static void sqrMod(limb_t* r, const limb_t* a, const limb_t* m, int mn, limb_t* prod){
+	limbSqr(prod, a, mn);
+	limbDivRem(0, r, prod, 2*mn, m, mn);
+}
+
+//x^y mod m using sliding window exponentiation.
+BigNum modPow(const BigNum& x, const BigNum& y, const BigNum& m){
+	BigNum result;
+	int mn = m.size();
+
+	if(mn == 0 || (mn == 1 && m.limb(0) == 1)){
+		return result;
+	}
+	if(y.isZero()){
+		result = 1;
+		return result;
+	}
+	if(mn == 1){
+		return BigNum(wordPowMod(x.size() > 1 ? BigNum::divModWord(0, x, m.limb(0)) : x.limb(0), y.limbs(), y.size(), m.limb(0)));
+	}
+	//Odd moduli (every RSA modulus and prime) go through Montgomery once it beats
+	//division at their size.
+	if(m.isOdd() && mn >= Tuning::current().montgomeryMinLimbs){
+		MontContext ctx(m);
+		return ctx.pow(x, y);
+	}
+	result.reserve(mn);
+
+	LimbArena& arena = scratchArena();
+	ArenaScope scope(arena);
+	int k = expWindowBits(y.bitLength());
+	int tableSize = 1 << (k-1);
+	limb_t* table = arena.take(tableSize*mn);
+	limb_t* acc = arena.take(mn);
+	limb_t* base2 = arena.take(mn);
+	limb_t* prod = arena.take(2*mn);
+
+	//table[i] = x^(2i+1) mod m.
+	std::memset(table, 0, mn*sizeof(limb_t));
+	if(x.size() >= mn){
+		limbDivRem(0, table, x.limbs(), x.size(), m.limbs(), mn);
+	}
+	else{
+		std::memcpy(table, x.limbs(), x.size()*sizeof(limb_t));
+	}
+	if(tableSize > 1){
+		sqrMod(base2, table, m.limbs(), mn, prod);
+		for(int i=1; i<tableSize; i++){
+			mulMod(table + i*mn, table + (i-1)*mn, base2, m.limbs(), mn, prod);
+		}
+	}
+
+	bool started = false;
+	int i = y.bitLength() - 1;
+	while(i >= 0){
+		if(!y[i]){
+			if(started){
+				sqrMod(acc, acc, m.limbs(), mn, prod);
+			}
+			i--;
+			continue;
+		}
+		//Take the longest window ending in a set bit.
+		int j = (i - k + 1 > 0) ? (i - k + 1) : 0;
+		while(!y[j]){
+			j++;
+		}
+		int val = 0;
+		for(int b=i; b>=j; b--){
+			val = (val << 1) | y[b];
+		}
+		if(started){
+			for(int b=i; b>=j; b--){
+				sqrMod(acc, acc, m.limbs(), mn, prod);
+			}
+			mulMod(acc, acc, table + ((val-1)/2)*mn, m.limbs(), mn, prod);
+		}
+		else{
+			std::memcpy(acc, table + ((val-1)/2)*mn, mn*sizeof(limb_t));
+			started = true;
+		}
+		i = j - 1;
+	}
+
+	result.setLimbs(acc, mn);
+	return result;
+}
+
+BigNum multiModPow(const std::vector<std::pair<BigNum, BigNum> >& terms, const BigNum& m){
+	int mn = m.size();
+	if(mn == 0 || (mn == 1 && m.limb(0) == 1)){
+		return BigNum();
+	}
+	if(mn == 1){
+		limb_t mw = m.limb(0);
+		limb_t acc = 1;
+		for(size_t i=0; i<terms.size(); i++){
+			acc = wordMulMod(acc, modPow(terms[i].first, terms[i].second, m).limb(0), mw);
+		}
+		return BigNum(acc);
+	}
+	if(m.isOdd()){
+		MontContext ctx(m);
+		return ctx.multiPow(terms);
+	}
+	BigNum result(1);
+	for(size_t i=0; i<terms.size(); i++){
+		result = (result * modPow(terms[i].first, terms[i].second, m)) % m;
+	}
+	return result;
+}
+
+//extended Euclidean algorithm.  Find b s.t. ab = 1 mod m
+BigNum modInverse(const BigNum& a, const BigNum& m){
+	BigNum response;
+	int mn = m.size();
+
+	if(mn == 0 || m == 1){
+		return response;
+	}
+	if(mn == 1){
+		return BigNum(wordModInverse(a.size() > 1 ? BigNum::divModWord(0, a, m.limb(0)) : a.limb(0), m.limb(0)));
+	}
+	LimbArena& arena = scratchArena();
+	ArenaScope scope(arena);
+	//r0 = s0*a, r1 = s1*a (mod m), with the signs of s0, s1 kept separately.
+	BigNum r0(arena), r1(arena), s0(arena), s1(arena), q(arena), r(arena), t(arena);
+	bool neg0 = false, neg1 = false;
+	r0.reserve(mn + 1);
+	r1.reserve(mn + 1);
+	s0.reserve(mn + 1);
+	s1.reserve(mn + 1);
+	q.reserve(mn + 1);
+	r.reserve(mn + 1);
+	t.reserve(2*mn + 2);
+
+	r0 = m;
+	BigNum::divMod(0, &r1, a, m);
+	s1 = 1;
+	while(!r1.isZero()){
+		BigNum::divMod(&q, &r, r0, r1);
+		//s2 = s0 - q*s1
+		BigNum::mul(t, q, s1);
+		bool negT = neg1;
+		if(neg0 != negT){
+			BigNum::add(t, s0, t);
+			negT = neg0;
+		}
+		else if(s0 >= t){
+			BigNum::sub(t, s0, t);
+			negT = neg0;
+		}
+		else{
+			BigNum::sub(t, t, s0);
+			negT = !neg0;
+		}
+		r0.swap(r1);
+		r1.swap(r);
+		s0.swap(s1);
+		s1.swap(t);
+		neg0 = neg1;
+		neg1 = negT;
+	}
+	if(!(r0 == 1)){
+		return response;
+	}
+	BigNum::divMod(0, &response, s0, m);
+	if(neg0 && !response.isZero()){
+		response = m - response;
+	}
+	return response;
+}
+
+BigNum gcd(const BigNum& i, const BigNum& j){
+	if(i.size() <= 1 && j.size() <= 1){
+		return BigNum(wordGcd(i.limb(0), j.limb(0)));
+	}
+	//With one operand a single limb, the first remainder already fits in a word.
+	if(j.size() == 1){
+		return BigNum(wordGcd(BigNum::divModWord(0, i, j.limb(0)), j.limb(0)));
+	}
+	if(i.size() == 1){
+		return BigNum(wordGcd(BigNum::divModWord(0, j, i.limb(0)), i.limb(0)));
+	}
+	LimbArena& arena = scratchArena();
+	ArenaScope scope(arena);
+	int n = (i.size() > j.size()) ? i.size() : j.size();
+	BigNum a(arena), b(arena), r(arena);
+	a.reserve(n);
+	b.reserve(n);
+	r.reserve(n);
+	a = i;
+	b = j;
+	while(!b.isZero()){
+		BigNum::divMod(0, &r, a, b);
+		a.swap(b);
+		b.swap(r);
+	}
+	return BigNum(a);
+}
+
+BigNum mulFull(const std::vector<BigNum>& nums, size_t first, size_t last){
+	if(last <= first){
+		return BigNum(1);
+	}
+	if(last - first == 1){
+		return nums[first];
+	}
+	BigNum response;
+	if(last - first == 2){
+		BigNum::mul(response, nums[first], nums[first + 1]);
+		return response;
+	}
+	size_t mid = first + (last - first)/2;
+	BigNum::mul(response, mulFull(nums, first, mid), mulFull(nums, mid, last));
+	return response;
+}
+
+}
@@ -0,0 +1,321 @@
+#ifndef BIGNUM_H_
+#define BIGNUM_H_
+#include <string>
+#include <utility>
+#include <vector>
+#include "BigInt.h"
+#include "Limb.h"
+#include "LimbAllocator.h"
+
+namespace RSAUtil
+{
+	//Number of limbs a BigNum holds without spilling to its allocator.
+	#ifndef BIGNUM_INLINE_LIMBS
+	#define BIGNUM_INLINE_LIMBS 4
+	#endif
+
+	/*
+	 * **********************************************************************************
+	 * A class for representing non-negative integers of any size.  Unlike BigInt,
+	 * whose width is fixed at BIGINT_SIZE bits, a BigNum grows as needed, so values
+	 * of different sizes (e.g. moduli of different key lengths) can be mixed in one
+	 * process.
+	 *
+	 * The magnitude is stored in 64 bit limbs.  Up to BIGNUM_INLINE_LIMBS limbs are
+	 * kept inside the object itself; larger values spill to a LimbAllocator, which is
+	 * the process default pool unless one is given to the constructor.  modPow,
+	 * modInverse, gcd and division take their temporaries from the calling thread's
+	 * scratch arena, so once the pool and the arena are warm, repeated operations on
+	 * numbers of the same size do not touch the heap.
+	 *
+	 * BigNum does not represent negative numbers.  Subtracting a larger number from a
+	 * smaller one gives 0, as does dividing by 0.
+	 *
+	 * @class: BigNum
+	 * @namespace: RSAUtil
+	 * @file: BigNum.h
+	 * @version: 1.0.0.0
+	 * @date: 10/18/2026
+	 * **********************************************************************************
+	 */
+
+class BigNum
+{
+private:
+	//The limbs, least significant first.  Points at local or at spilled storage.
+	limb_t* d;
+	//Number of significant limbs.  d[used-1] != 0, and used == 0 for zero.
+	int used;
+	//Number of limbs available at d.
+	int cap;
+	//Where to spill when the value outgrows cap.
+	LimbAllocator* alloc;
+	limb_t local[BIGNUM_INLINE_LIMBS];
+
+	void init(LimbAllocator*);
+	void grow(int, bool);
+	void trim();
+	void assign(const BigNum&);
+	bool isSpilled() const;
+
+public:
+	/*
+	 * *******************************************************************************
+	 * Constructors.
+	 * BigNum(): The number is 0.
+	 * BigNum(unsigned long long): The number is the given value.
+	 * BigNum(BigInt): The number is the value of the given BigInt.
+	 * BigNum(LimbAllocator&): The number is 0, and spills to the given allocator.
+	 * 					Temporaries that use the scratch arena are made this way.
+	 * Copies spill to the allocator of the original, unless that is an arena, in
+	 * which case they use the default allocator.
+	 * *******************************************************************************
+	 */
+	BigNum();
+	BigNum(unsigned long long);
+	BigNum(const BigInt&);
+	explicit BigNum(LimbAllocator&);
+	BigNum(const BigNum&);
+	BigNum(BigNum&&);
+	virtual ~BigNum();
+
+	BigNum& operator=(const BigNum&);
+	BigNum& operator=(BigNum&&);
+
+	/*
+	 * *******************************************************************************
+	 * Arithmetic operators.  See the class comment for subtraction and division
+	 * by 0.
+	 * *******************************************************************************
+	 */
+	BigNum operator+(const BigNum&) const;
+	BigNum operator-(const BigNum&) const;
+	BigNum operator*(const BigNum&) const;
+	BigNum operator/(const BigNum&) const;
+	BigNum operator%(const BigNum&) const;
+	BigNum& operator+=(const BigNum&);
+	BigNum& operator-=(const BigNum&);
+	BigNum& operator*=(const BigNum&);
+	BigNum& operator/=(const BigNum&);
+	BigNum& operator%=(const BigNum&);
+
+	/*
+	 * *******************************************************************************
+	 * Arithmetic with a single limb.  Each is one pass of the matching limb kernel
+	 * instead of a widening to BigNum and the general algorithm, and any integer
+	 * operand picks these over the operators above, so p - 1, phi/6 or c % 3 need
+	 * no change at the call site.  Subtraction and division by 0 behave as above.
+	 * *******************************************************************************
+	 */
+	BigNum operator+(limb_t) const;
+	BigNum operator-(limb_t) const;
+	BigNum operator*(limb_t) const;
+	BigNum operator/(limb_t) const;
+	BigNum operator%(limb_t) const;
+	BigNum& operator+=(limb_t);
+	BigNum& operator-=(limb_t);
+	BigNum& operator*=(limb_t);
+	BigNum& operator/=(limb_t);
+	BigNum& operator%=(limb_t);
+
+	/*
+	 * *******************************************************************************
+	 * Logical shift operators.
+	 * @parameter int:	The shift amount, in bits.
+	 * *******************************************************************************
+	 */
+	BigNum operator<<(int) const;
+	BigNum operator>>(int) const;
+	BigNum& operator<<=(int);
+	BigNum& operator>>=(int);
+
+	/*
+	 * *******************************************************************************
+	 * Comparison operators.
+	 * *******************************************************************************
+	 */
+	bool operator==(const BigNum&) const;
+	bool operator!=(const BigNum&) const;
+	bool operator<(const BigNum&) const;
+	bool operator<=(const BigNum&) const;
+	bool operator>(const BigNum&) const;
+	bool operator>=(const BigNum&) const;
+
+	/*
+	 * *******************************************************************************
+	 * compare.	Three-way comparison.
+	 * @returns int:	-1, 0 or 1 as this BigNum is less than, equal to or greater
+	 * 					than the given one.
+	 * *******************************************************************************
+	 */
+	int compare(const BigNum&) const;
+
+	/*
+	 * *******************************************************************************
+	 * In-place forms of the arithmetic operators.  The result goes into the first
+	 * parameter, which keeps its allocator, so arena-backed temporaries stay in the
+	 * arena.  The result may be the same object as an operand.  sqr(r, a) is
+	 * mul(r, a, a) through limbSqr.  divMod accepts null for the quotient or the
+	 * remainder.
+	 * *******************************************************************************
+	 */
+	static void add(BigNum&, const BigNum&, const BigNum&);
+	static void sub(BigNum&, const BigNum&, const BigNum&);
+	static void mul(BigNum&, const BigNum&, const BigNum&);
+	static void sqr(BigNum&, const BigNum&);
+	static void divMod(BigNum*, BigNum*, const BigNum&, const BigNum&);
+
+	/*
+	 * *******************************************************************************
+	 * In-place forms of the single limb operators, on the same terms.  divModWord
+	 * returns the remainder as a limb and accepts null for the quotient, so trial
+	 * division is divModWord(0, p, small) == 0.
+	 * *******************************************************************************
+	 */
+	static void addWord(BigNum&, const BigNum&, limb_t);
+	static void subWord(BigNum&, const BigNum&, limb_t);
+	static void mulWord(BigNum&, const BigNum&, limb_t);
+	static limb_t divModWord(BigNum*, const BigNum&, limb_t);
+
+	/*
+	 * *******************************************************************************
+	 * reserve.	Makes room for the given number of limbs without changing the value.
+	 * *******************************************************************************
+	 */
+	void reserve(int);
+
+	/*
+	 * *******************************************************************************
+	 * swap.	Exchanges the values of two BigNums.  Each keeps its own allocator.
+	 * *******************************************************************************
+	 */
+	void swap(BigNum&);
+
+	/*
+	 * *******************************************************************************
+	 * Limb access.  size() is the number of significant limbs; limb(i) is 0 past
+	 * the top.  limbs() points at size() limbs, least significant first.
+	 * setLimbs() replaces the value with the given limb array.
+	 * *******************************************************************************
+	 */
+	int size() const;
+	limb_t limb(int) const;
+	const limb_t* limbs() const;
+	void setLimbs(const limb_t*, int);
+
+	/*
+	 * *******************************************************************************
+	 * Overloaded indexing operator.
+	 * @parameter int:	The index of the bit to get.
+	 * @returns int:	The bit (1 or 0), or -1 for a negative index.
+	 * *******************************************************************************
+	 */
+	int operator[](int) const;
+
+	/*
+	 * *******************************************************************************
+	 * bitLength.	Number of bits up to and including the highest set bit.
+	 * *******************************************************************************
+	 */
+	int bitLength() const;
+
+	bool isZero() const;
+	bool isOdd() const;
+
+	/*
+	 * *******************************************************************************
+	 * toHexString.	Hexadecimal representation, grouped the same way as
+	 * 				BigInt::toHexString().
+	 * toDecString.	Decimal representation.
+	 * *******************************************************************************
+	 */
+	std::string toHexString() const;
+	std::string toDecString() const;
+
+	/*
+	 * *******************************************************************************
+	 * toBigInt.	The low BIGINT_SIZE bits of this BigNum as a BigInt.
+	 * *******************************************************************************
+	 */
+	BigInt toBigInt() const;
+
+	/*
+	 * *******************************************************************************
+	 * fromHex.	Parses a hexadecimal string.  A leading "0x" and any spaces are
+	 * 			ignored, so toHexString() output reads back.
+	 * fromDec.	Parses a decimal string.
+	 * *******************************************************************************
+	 */
+	static BigNum fromHex(const std::string&);
+	static BigNum fromDec(const std::string&);
+};
+
+	/*
+	 * *********************************************************************************
+	 * expWindowBits.	Window width the sliding window exponentiations use for an
+	 * 					exponent of the given number of bits, from the thresholds
+	 * 					in Tuning::current().
+	 * *********************************************************************************
+	 */
+	int expWindowBits(int);
+
+	/*
+	 * *********************************************************************************
+	 * modPow.	Performs modular exponentiation [a^b] mod m using a sliding window.
+	 * 			Odd moduli are reduced with Montgomery multiplication (see
+	 * 			Montgomery.h), even ones by long division.
+	 * @parameter BigNum:	The base.
+	 * @parameter BigNum:	The exponent.
+	 * @parameter BigNum:	The modulus.
+	 * @returns BigNum:		[a^b] mod m, or 0 if m is 0.
+	 * *********************************************************************************
+	 */
+	BigNum modPow(const BigNum&, const BigNum&, const BigNum&);
+
+	/*
+	 * *********************************************************************************
+	 * multiModPow.	Product of powers [a1^b1 * a2^b2 * ...] mod m.  The exponents are
+	 * 				walked together from the top bit (Straus/Shamir), so all the terms
+	 * 				share one chain of squarings and each only adds the
+	 * 				multiplications of its own windows.  Odd moduli go through
+	 * 				MontContext::multiPow(); even ones take a modPow per term.
+	 * @parameter std::vector<std::pair<BigNum, BigNum> >:	The (base, exponent) terms.
+	 * @parameter BigNum:	The modulus.
+	 * @returns BigNum:		The product mod m (1 mod m for no terms), or 0 if m is 0.
+	 * *********************************************************************************
+	 */
+	BigNum multiModPow(const std::vector<std::pair<BigNum, BigNum> >&, const BigNum&);
+
+	/*
+	 * *********************************************************************************
+	 * modInverse.	Uses the extended Euclidian algorithm to find b such that
+	 * 				[ab == 1] mod m.
+	 * @returns BigNum:		b, or 0 if a has no inverse mod m.
+	 * *********************************************************************************
+	 */
+	BigNum modInverse(const BigNum&, const BigNum&);
+
+	/*
+	 * *********************************************************************************
+	 * gcd.	Greatest common divisor by the Euclidian algorithm.
+	 * *********************************************************************************
+	 */
+	BigNum gcd(const BigNum&, const BigNum&);
+
+	/*
+	 * *********************************************************************************
+	 * mulFull.	The full, unreduced product of nums[first] .. nums[last-1].  The
+	 * 			range is multiplied as a balanced tree, halves first, so that the
+	 * 			long products near the top have operands of about the same length
+	 * 			and reach the Karatsuba and NTT paths of limbMul (see Tuning.h)
+	 * 			instead of one long running product times a short factor.
+	 * @parameter std::vector<BigNum>:	The factors.
+	 * @parameter size_t, size_t:	The range, first and one past the last.
+	 * @returns BigNum:		The product, or 1 for an empty range.
+	 * *********************************************************************************
+	 */
+	BigNum mulFull(const std::vector<BigNum>&, size_t, size_t);
+
+}
+
+#endif /*BIGNUM_H_*/
@@ -0,0 +1,156 @@
+#include "BlindSigner.h"
+#include <random>
+
+namespace RSAUtil
+{
+
+BlindSigner::BlindSigner(const PublicKey& key, size_t poolSize)
+	: pub(key), capacity(poolSize), stopping(false)
+{
+	start();
+}
+
+BlindSigner::BlindSigner(const PrivateKey& key, size_t poolSize)
+	: pub(key.getPublicKey()), priv(std::make_shared<const PrivateKey>(key)),
+	capacity(poolSize), stopping(false)
+{
+	start();
+}
+
+BlindSigner::~BlindSigner()
+{
+	if(refiller.joinable()){
+		{
+			std::lock_guard<std::mutex> guard(poolLock);
+			stopping = true;
+		}
+		poolLow.notify_one();
+		refiller.join();
+	}
+}
+
+void BlindSigner::start(){
+	const BigNum& n = pub.getModulus();
+	if(n.isOdd() && n > 1){
+		mont = std::make_shared<const MontContext>(n);
+	}
+	if(capacity > 0){
+		refiller = std::thread(&BlindSigner::refill, this);
+	}
+}
+
+const PublicKey& BlindSigner::getPublicKey() const{
+	return pub;
+}
+
+size_t BlindSigner::poolLevel(){
+	std::lock_guard<std::mutex> guard(poolLock);
+	return pool.size();
+}
+
+// A fresh factor: r uniform in [2, n-1] with gcd(r, n) == 1.
+BlindSigner::Factor BlindSigner::makeFactor() const{
+	static thread_local std::random_device device;
+	const BigNum& n = pub.getModulus();
+	//One limb more than n keeps the bias of the final "% n" negligible.
+	std::vector<limb_t> limbs(n.size() + 1);
+	Factor f;
+	do{
+		for(size_t i=0; i<limbs.size(); i++){
+			limbs[i] = ((limb_t)device() << 32) | device();
+		}
+		BigNum r;
+		r.setLimbs(&limbs[0], (int)limbs.size());
+		r = r % n;
+		f.rInv = (r > 1) ? modInverse(r, n) : BigNum();
+		if(!f.rInv.isZero() && mont){
+			f.reMont = ModInt(mont, pub.encrypt(r));
+		}
+		else if(!f.rInv.isZero()){
+			f.re = pub.encrypt(r);
+		}
+	}while(f.rInv.isZero());
+	return f;
+}
+
+BlindSigner::Factor BlindSigner::takeFactor(){
+	{
+		std::lock_guard<std::mutex> guard(poolLock);
+		if(!pool.empty()){
+			Factor f = pool.front();
+			pool.pop_front();
+			if(pool.size() <= capacity/2){
+				poolLow.notify_one();
+			}
+			return f;
+		}
+	}
+	//The pool ran dry; make one here rather than wait for the thread.
+	return makeFactor();
+}
+
+// Body of the refill thread.  Waits for the pool to drop below half full, then
+// fills it back up, making each factor outside the lock.
+void BlindSigner::refill(){
+	std::unique_lock<std::mutex> guard(poolLock);
+	while(!stopping){
+		if(pool.size() > capacity/2){
+			poolLow.wait(guard);
+			continue;
+		}
+		while(!stopping && pool.size() < capacity){
+			guard.unlock();
+			Factor f = makeFactor();
+			guard.lock();
+			pool.push_back(f);
+		}
+	}
+}
+
+BigNum BlindSigner::blind(const BigNum& msg, BigNum& unblinder){
+	Factor f = takeFactor();
+	unblinder = f.rInv;
+	if(mont){
+		return f.reMont.mulPlain(msg);
+	}
+	return (msg * f.re) % pub.getModulus();
+}
+
+BigNum BlindSigner::signBlinded(const BigNum& blinded) const{
+	if(!priv){
+		return BigNum();
+	}
+	return priv->sign(blinded);
+}
+
+BigNum BlindSigner::unblind(const BigNum& sig, const BigNum& unblinder) const{
+	return (sig * unblinder) % pub.getModulus();
+}
+
+std::vector<BigNum> BlindSigner::blindBatch(const std::vector<BigNum>& msgs,
+		std::vector<BigNum>& unblinders){
+	std::vector<BigNum> response(msgs.size());
+	unblinders.resize(msgs.size());
+	for(size_t i=0; i<msgs.size(); i++){
+		response[i] = blind(msgs[i], unblinders[i]);
+	}
+	return response;
+}
+
+std::vector<BigNum> BlindSigner::signBlindedBatch(const std::vector<BigNum>& blinded) const{
+	if(!priv){
+		return std::vector<BigNum>(blinded.size());
+	}
+	return priv->decryptBatch(blinded);
+}
+
+std::vector<BigNum> BlindSigner::unblindBatch(const std::vector<BigNum>& sigs,
+		const std::vector<BigNum>& unblinders) const{
+	std::vector<BigNum> response(sigs.size());
+	for(size_t i=0; i<sigs.size(); i++){
+		response[i] = unblind(sigs[i], unblinders[i]);
+	}
+	return response;
+}
+
+}
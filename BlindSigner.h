@@ -0,0 +1,141 @@
+#ifndef BLINDSIGNER_H_
+#define BLINDSIGNER_H_
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "ModInt.h"
+#include "RSAKey.h"
+
+namespace RSAUtil
+{
+
+/****************************************************************************************
+ * Chaum's RSA blind signatures.  The requester blinds a message m with a random r
+ * coprime to n, sending m' = m*r^e mod n; the signer signs m' as usual, giving
+ * s' = m^d * r; the requester unblinds with s = s' * r^-1 mod n, a plain signature
+ * on m that the signer never saw.
+ *
+ * Finding r^e and r^-1 costs an exponentiation and an inversion, so the pairs are
+ * made ahead of time by a background thread that keeps a pool of them topped up.
+ * blind() and unblind() are then one modular multiplication each; blind() only
+ * makes a pair itself if the pool has run dry.  Each pair is used once.  For an odd
+ * n, r^e is kept as a ModInt, so blinding is a single Montgomery product.
+ *
+ * A BlindSigner built from a public key can blind and unblind; one built from a
+ * private key can also sign.  All calls may be made from any thread.
+ *
+ * @class: BlindSigner
+ * @namespace: RSAUtil
+ * @file: BlindSigner.h
+ * @version: 1.0.0.0
+ * @date: 10/18/2026
+ * **************************************************************************************
+ */
+class BlindSigner
+{
+private:
+	//A blinding factor r^e mod n and its unblinder r^-1 mod n.  r^e is in reMont
+	//when there is a Montgomery context, else in re.
+	struct Factor
+	{
+		BigNum re;
+		ModInt reMont;
+		BigNum rInv;
+	};
+
+	PublicKey pub;
+	//Montgomery context for n; null when n is even.
+	std::shared_ptr<const MontContext> mont;
+	//Null when built from a public key.
+	std::shared_ptr<const PrivateKey> priv;
+
+	//Pool of ready factors, refilled once it drops below half of capacity.
+	std::deque<Factor> pool;
+	size_t capacity;
+	std::mutex poolLock;
+	std::condition_variable poolLow;
+	bool stopping;
+	std::thread refiller;
+
+	Factor makeFactor() const;
+	Factor takeFactor();
+	void refill();
+	void start();
+
+	BlindSigner(const BlindSigner&);
+	BlindSigner& operator=(const BlindSigner&);
+
+public:
+	/*
+	 * *******************************************************************************
+	 * Constructors.
+	 * @parameter PublicKey / PrivateKey:	The signer's key.
+	 * @parameter size_t:	Number of factors to keep ready.  0 turns the pool and its
+	 * 					thread off, e.g. for a signer that only signs.
+	 * *******************************************************************************
+	 */
+	BlindSigner(const PublicKey&, size_t poolSize = 64);
+	BlindSigner(const PrivateKey&, size_t poolSize = 64);
+
+	/*
+	 * *******************************************************************************
+	 * Destructor.  Stops the refill thread.
+	 * *******************************************************************************
+	 */
+	virtual ~BlindSigner();
+
+	const PublicKey& getPublicKey() const;
+
+	/*
+	 * *******************************************************************************
+	 * poolLevel.	Number of factors ready right now.
+	 * *******************************************************************************
+	 */
+	size_t poolLevel();
+
+	/*
+	 * *******************************************************************************
+	 * blind.	Blinds a message below n.
+	 * @parameter BigNum:	The message.
+	 * @parameter BigNum&:	Receives the unblinder to pass to unblind() later.
+	 * @returns BigNum:	The blinded message, to be signed by signBlinded().
+	 * *******************************************************************************
+	 */
+	BigNum blind(const BigNum&, BigNum&);
+
+	/*
+	 * *******************************************************************************
+	 * signBlinded.	Signs a blinded message.  Only valid when built from a
+	 * 				private key; returns 0 otherwise.
+	 * *******************************************************************************
+	 */
+	BigNum signBlinded(const BigNum&) const;
+
+	/*
+	 * *******************************************************************************
+	 * unblind.	Turns a signature on a blinded message into one on the message.
+	 * @parameter BigNum:	The signature returned by signBlinded().
+	 * @parameter BigNum:	The unblinder blind() gave for that message.
+	 * @returns BigNum:	The signature on the original message.
+	 * *******************************************************************************
+	 */
+	BigNum unblind(const BigNum&, const BigNum&) const;
+
+	/*
+	 * *******************************************************************************
+	 * Batch forms of the above; element i of each result belongs to element i of
+	 * the input.  signBlindedBatch goes through PrivateKey::decryptBatch.
+	 * *******************************************************************************
+	 */
+	std::vector<BigNum> blindBatch(const std::vector<BigNum>&, std::vector<BigNum>&);
+	std::vector<BigNum> signBlindedBatch(const std::vector<BigNum>&) const;
+	std::vector<BigNum> unblindBatch(const std::vector<BigNum>&,
+			const std::vector<BigNum>&) const;
+};
+
+}
+
+#endif /*BLINDSIGNER_H_*/
@@ -0,0 +1,119 @@
+#include "LatencyHistogram.h"
+#include <sstream>
+
+namespace RSAUtil
+{
+
+//Values below 2^HISTOGRAM_SUB_BITS have a bucket each; every power of two above
+//that has 2^HISTOGRAM_SUB_BITS buckets.
+#define HISTOGRAM_SUB_COUNT (1 << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_BUCKETS ((64 - HISTOGRAM_SUB_BITS + 1) * HISTOGRAM_SUB_COUNT)
+
+LatencyHistogram::LatencyHistogram()
+	: counts(HISTOGRAM_BUCKETS, 0), total(0), minValue(0), maxValue(0), sum(0)
+{
+}
+
+LatencyHistogram::~LatencyHistogram()
+{
+}
+
+int LatencyHistogram::bucketOf(unsigned long long value){
+	if(value < HISTOGRAM_SUB_COUNT){
+		return (int)value;
+	}
+	//The top HISTOGRAM_SUB_BITS+1 bits pick the bucket within the power of two.
+	int top = 63 - __builtin_clzll(value);
+	int shift = top - HISTOGRAM_SUB_BITS;
+	int sub = (int)(value >> shift) - HISTOGRAM_SUB_COUNT;
+	return (shift + 1)*HISTOGRAM_SUB_COUNT + sub;
+}
+
+unsigned long long LatencyHistogram::bucketTop(int bucket){
+	if(bucket < HISTOGRAM_SUB_COUNT){
+		return bucket;
+	}
+	int shift = bucket / HISTOGRAM_SUB_COUNT - 1;
+	unsigned long long sub = bucket % HISTOGRAM_SUB_COUNT + HISTOGRAM_SUB_COUNT;
+	return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(unsigned long long value){
+	counts[bucketOf(value)]++;
+	if(total == 0 || value < minValue){
+		minValue = value;
+	}
+	if(value > maxValue){
+		maxValue = value;
+	}
+	total++;
+	sum += (double)value;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other){
+	if(other.total == 0){
+		return;
+	}
+	for(size_t i=0; i<counts.size(); i++){
+		counts[i] += other.counts[i];
+	}
+	if(total == 0 || other.minValue < minValue){
+		minValue = other.minValue;
+	}
+	if(other.maxValue > maxValue){
+		maxValue = other.maxValue;
+	}
+	total += other.total;
+	sum += other.sum;
+}
+
+unsigned long long LatencyHistogram::count() const{
+	return total;
+}
+
+unsigned long long LatencyHistogram::min() const{
+	return minValue;
+}
+
+unsigned long long LatencyHistogram::max() const{
+	return maxValue;
+}
+
+double LatencyHistogram::mean() const{
+	return total ? sum / total : 0.0;
+}
+
+unsigned long long LatencyHistogram::percentile(double pct) const{
+	if(total == 0){
+		return 0;
+	}
+	//Rank of the wanted value, 1-based, rounded up.
+	unsigned long long rank = (unsigned long long)(pct / 100.0 * total + 0.999999);
+	if(rank < 1){
+		rank = 1;
+	}
+	unsigned long long seen = 0;
+	for(size_t i=0; i<counts.size(); i++){
+		seen += counts[i];
+		if(seen >= rank){
+			unsigned long long top = bucketTop((int)i);
+			return (top < maxValue) ? top : maxValue;
+		}
+	}
+	return maxValue;
+}
+
+std::string LatencyHistogram::toJson() const{
+	std::ostringstream s;
+	s << "{\"count\": " << total
+		<< ", \"min_us\": " << minValue / 1e3
+		<< ", \"mean_us\": " << mean() / 1e3
+		<< ", \"p50_us\": " << percentile(50) / 1e3
+		<< ", \"p90_us\": " << percentile(90) / 1e3
+		<< ", \"p99_us\": " << percentile(99) / 1e3
+		<< ", \"p99.9_us\": " << percentile(99.9) / 1e3
+		<< ", \"max_us\": " << maxValue / 1e3 << "}";
+	return s.str();
+}
+
+}
@@ -0,0 +1,85 @@
+#ifndef LATENCYHISTOGRAM_H_
+#define LATENCYHISTOGRAM_H_
+#include <string>
+#include <vector>
+
+namespace RSAUtil
+{
+
+//Sub-buckets per power of two, as a power of two: 2^7 keeps every bucket within
+//1/128 (under 1%) of the values it holds.
+#define HISTOGRAM_SUB_BITS 7
+
+/****************************************************************************************
+ * A latency histogram in the style of HdrHistogram.  Values (nanoseconds) are kept
+ * in log-linear buckets: exact below 2^HISTOGRAM_SUB_BITS, and above that each
+ * power of two is split into 2^HISTOGRAM_SUB_BITS equal buckets, so any percentile
+ * is reported to within 1% using a few thousand counters, whatever the range.
+ *
+ * A histogram is not thread-safe; give each thread its own and merge() them.
+ *
+ * @class: LatencyHistogram
+ * @namespace: RSAUtil
+ * @file: LatencyHistogram.h
+ * @version: 1.0.0.0
+ * @date: 10/18/2026
+ * **************************************************************************************
+ */
+class LatencyHistogram
+{
+private:
+	std::vector<unsigned long long> counts;
+	unsigned long long total;
+	unsigned long long minValue;
+	unsigned long long maxValue;
+	double sum;
+
+	static int bucketOf(unsigned long long);
+	static unsigned long long bucketTop(int);
+
+public:
+	LatencyHistogram();
+	virtual ~LatencyHistogram();
+
+	/*
+	 * *******************************************************************************
+	 * record.	Adds one value, in nanoseconds.
+	 * *******************************************************************************
+	 */
+	void record(unsigned long long);
+
+	/*
+	 * *******************************************************************************
+	 * merge.	Adds every value recorded in another histogram.
+	 * *******************************************************************************
+	 */
+	void merge(const LatencyHistogram&);
+
+	unsigned long long count() const;
+	unsigned long long min() const;
+	unsigned long long max() const;
+	double mean() const;
+
+	/*
+	 * *******************************************************************************
+	 * percentile.	The value below which the given percentage of the recorded
+	 * 				values fall, e.g. percentile(99.9); 0 if nothing was recorded.
+	 * @parameter double:	The percentage, 0 to 100.
+	 * @returns unsigned long long:	The value in nanoseconds, rounded up to the top
+	 * 								of its bucket.
+	 * *******************************************************************************
+	 */
+	unsigned long long percentile(double) const;
+
+	/*
+	 * *******************************************************************************
+	 * toJson.	Summary as a JSON object: count, min, mean, p50, p90, p99, p99.9
+	 * 			and max, all in microseconds.
+	 * *******************************************************************************
+	 */
+	std::string toJson() const;
+};
+
+}
+
+#endif /*LATENCYHISTOGRAM_H_*/
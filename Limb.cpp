@@ -0,0 +1,657 @@
+#include "Limb.h"
+#include "LimbAllocator.h"
+#include "Tuning.h"
+#include <cstring>
+#include <cstdlib>
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <cpuid.h>
+#endif
+
+namespace RSAUtil
+{
+
+static limb_t addPortable(limb_t* r, const limb_t* a, const limb_t* b, int n){
+	limb_t carry = 0;
+	for(int i=0; i<n; i++){
+		limb_t s = a[i] + carry;
+		carry = (s < carry);
+		r[i] = s + b[i];
+		carry += (r[i] < s);
+	}
+	return carry;
+}
+
+//The carry usually dies in the first limb; past that point the rest is a copy, or
+//nothing at all when r is a.
+limb_t limbAdd1(limb_t* r, const limb_t* a, int n, limb_t w){
+	int i = 0;
+	for(; i<n && w; i++){
+		r[i] = a[i] + w;
+		w = (r[i] < w);
+	}
+	if(r != a){
+		for(; i<n; i++){
+			r[i] = a[i];
+		}
+	}
+	return w;
+}
+
+static limb_t subPortable(limb_t* r, const limb_t* a, const limb_t* b, int n){
+	limb_t borrow = 0;
+	for(int i=0; i<n; i++){
+		limb_t ai = a[i];
+		limb_t d = ai - b[i];
+		limb_t b1 = (d > ai);
+		r[i] = d - borrow;
+		borrow = b1 | (r[i] > d);
+	}
+	return borrow;
+}
+
+limb_t limbSub1(limb_t* r, const limb_t* a, int n, limb_t w){
+	int i = 0;
+	for(; i<n && w; i++){
+		limb_t ai = a[i];
+		r[i] = ai - w;
+		w = (r[i] > ai);
+	}
+	if(r != a){
+		for(; i<n; i++){
+			r[i] = a[i];
+		}
+	}
+	return w;
+}
+
+limb_t limbMul1(limb_t* r, const limb_t* a, int n, limb_t w){
+	limb_t carry = 0;
+	for(int i=0; i<n; i++){
+		dlimb_t t = (dlimb_t)a[i] * w + carry;
+		r[i] = (limb_t)t;
+		carry = (limb_t)(t >> LIMB_BITS);
+	}
+	return carry;
+}
+
+static limb_t addMul1Portable(limb_t* r, const limb_t* a, int n, limb_t w){
+	limb_t carry = 0;
+	for(int i=0; i<n; i++){
+		dlimb_t t = (dlimb_t)a[i] * w + r[i] + carry;
+		r[i] = (limb_t)t;
+		carry = (limb_t)(t >> LIMB_BITS);
+	}
+	return carry;
+}
+
+limb_t limbSubMul1(limb_t* r, const limb_t* a, int n, limb_t w){
+	limb_t borrow = 0;
+	for(int i=0; i<n; i++){
+		dlimb_t t = (dlimb_t)a[i] * w + borrow;
+		limb_t lo = (limb_t)t;
+		borrow = (limb_t)(t >> LIMB_BITS);
+		limb_t ri = r[i];
+		r[i] = ri - lo;
+		borrow += (r[i] > ri);
+	}
+	return borrow;
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+
+// x86-64 carry chains.  The loops count down in rcx with lea and jrcxz, which leave
+// the flags alone, so one carry chain runs through the whole array.  Each limb is
+// loaded before its result is stored, so r may be a or b.
+#define LIMB_ADC_STEP(op, off) \
+		"mov " off "(%[a]), %[t]\n\t" \
+		op " " off "(%[b]), %[t]\n\t" \
+		"mov %[t], " off "(%[r])\n\t"
+
+#define LIMB_ADC_LOOP(op) \
+		"mov %[quads], %%rcx\n\t" \
+		"clc\n\t" \
+		"jrcxz 3f\n" \
+		"1:\n\t" \
+		LIMB_ADC_STEP(op, "0") \
+		LIMB_ADC_STEP(op, "8") \
+		LIMB_ADC_STEP(op, "16") \
+		LIMB_ADC_STEP(op, "24") \
+		"lea 32(%[a]), %[a]\n\t" \
+		"lea 32(%[b]), %[b]\n\t" \
+		"lea 32(%[r]), %[r]\n\t" \
+		"lea -1(%%rcx), %%rcx\n\t" \
+		"jrcxz 3f\n\t" \
+		"jmp 1b\n" \
+		"3:\n\t" \
+		"mov %[rest], %%rcx\n\t" \
+		"jrcxz 5f\n" \
+		"4:\n\t" \
+		LIMB_ADC_STEP(op, "0") \
+		"lea 8(%[a]), %[a]\n\t" \
+		"lea 8(%[b]), %[b]\n\t" \
+		"lea 8(%[r]), %[r]\n\t" \
+		"lea -1(%%rcx), %%rcx\n\t" \
+		"jrcxz 5f\n\t" \
+		"jmp 4b\n" \
+		"5:\n\t" \
+		"mov $0, %[c]\n\t" \
+		"adc $0, %[c]\n\t"
+
+static limb_t addX86(limb_t* r, const limb_t* a, const limb_t* b, int n){
+	unsigned long quads = n >> 2, rest = n & 3;
+	limb_t t, carry;
+	__asm__ volatile(LIMB_ADC_LOOP("adc")
+		: [t]"=&r"(t), [c]"=&r"(carry), [a]"+&r"(a), [b]"+&r"(b), [r]"+&r"(r)
+		: [quads]"r"(quads), [rest]"r"(rest)
+		: "rcx", "cc", "memory");
+	return carry;
+}
+
+static limb_t subX86(limb_t* r, const limb_t* a, const limb_t* b, int n){
+	unsigned long quads = n >> 2, rest = n & 3;
+	limb_t t, borrow;
+	__asm__ volatile(LIMB_ADC_LOOP("sbb")
+		: [t]"=&r"(t), [c]"=&r"(borrow), [a]"+&r"(a), [b]"+&r"(b), [r]"+&r"(r)
+		: [quads]"r"(quads), [rest]"r"(rest)
+		: "rcx", "cc", "memory");
+	return borrow;
+}
+
+#undef LIMB_ADC_LOOP
+#undef LIMB_ADC_STEP
+
+// r += a*w with BMI2 mulx, which leaves the flags alone, and two independent carry
+// chains: adox adds the previous high word into the low word (OF) and adcx adds
+// that into r (CF).  Four limbs per iteration, then the remainder one at a time.
+#define LIMB_MULX_STEP(off, hiIn, hiOut) \
+		"mulx " off "(%[a]), %[lo], %[" hiOut "]\n\t" \
+		"adox %[" hiIn "], %[lo]\n\t" \
+		"adcx " off "(%[r]), %[lo]\n\t" \
+		"mov %[lo], " off "(%[r])\n\t"
+
+__attribute__((target("bmi2,adx")))
+static limb_t addMul1Adx(limb_t* r, const limb_t* a, int n, limb_t w){
+	unsigned long quads = n >> 2, rest = n & 3;
+	limb_t hi = 0, lo, h2;
+	__asm__ volatile(
+		"xor %%r8d, %%r8d\n\t"
+		"mov %[quads], %%rcx\n\t"
+		"jrcxz 3f\n"
+		"1:\n\t"
+		LIMB_MULX_STEP("0", "hi", "h2")
+		LIMB_MULX_STEP("8", "h2", "hi")
+		LIMB_MULX_STEP("16", "hi", "h2")
+		LIMB_MULX_STEP("24", "h2", "hi")
+		"lea 32(%[a]), %[a]\n\t"
+		"lea 32(%[r]), %[r]\n\t"
+		"lea -1(%%rcx), %%rcx\n\t"
+		"jrcxz 3f\n\t"
+		"jmp 1b\n"
+		"3:\n\t"
+		"mov %[rest], %%rcx\n\t"
+		"jrcxz 5f\n"
+		"4:\n\t"
+		LIMB_MULX_STEP("0", "hi", "h2")
+		"mov %[h2], %[hi]\n\t"
+		"lea 8(%[a]), %[a]\n\t"
+		"lea 8(%[r]), %[r]\n\t"
+		"lea -1(%%rcx), %%rcx\n\t"
+		"jrcxz 5f\n\t"
+		"jmp 4b\n"
+		"5:\n\t"
+		"adox %%r8, %[hi]\n\t"
+		"adcx %%r8, %[hi]\n\t"
+		: [hi]"+&r"(hi), [lo]"=&r"(lo), [h2]"=&r"(h2), [a]"+&r"(a), [r]"+&r"(r)
+		: "d"(w), [quads]"r"(quads), [rest]"r"(rest)
+		: "rcx", "r8", "cc", "memory");
+	return hi;
+}
+
+#undef LIMB_MULX_STEP
+
+// CPUID leaf 7: EBX bit 8 is BMI2 and bit 19 is ADX.
+static bool cpuHasAdx(){
+	unsigned int eax, ebx, ecx, edx;
+	if(!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)){
+		return false;
+	}
+	return (ebx & (1u << 8)) && (ebx & (1u << 19));
+}
+
+#endif
+
+typedef limb_t (*LimbAddFn)(limb_t*, const limb_t*, const limb_t*, int);
+typedef limb_t (*LimbAddMul1Fn)(limb_t*, const limb_t*, int, limb_t);
+
+// One set of kernel variants.
+struct LimbKernels
+{
+	const char* name;
+	LimbAddFn add;
+	LimbAddFn sub;
+	LimbAddMul1Fn addMul1;
+};
+
+// Picks the best variant the CPU supports, unless LIMB_KERNELS_ENV names a plainer one.
+static LimbKernels pickKernels(){
+	LimbKernels portable = {"portable", addPortable, subPortable, addMul1Portable};
+	const char* wanted = std::getenv(LIMB_KERNELS_ENV);
+	if(wanted && std::strcmp(wanted, "portable") == 0){
+		return portable;
+	}
+#if defined(__x86_64__) && defined(__GNUC__)
+	LimbKernels x86 = {"x86-64", addX86, subX86, addMul1Portable};
+	LimbKernels adx = {"adx", addX86, subX86, addMul1Adx};
+	if(wanted && std::strcmp(wanted, "x86-64") == 0){
+		return x86;
+	}
+	return cpuHasAdx() ? adx : x86;
+#else
+	return portable;
+#endif
+}
+
+// Chosen on first use; a function local static so that static initializers in
+// other files may already call the kernels.
+static const LimbKernels& kernels(){
+	static const LimbKernels chosen = pickKernels();
+	return chosen;
+}
+
+const char* limbKernelName(){
+	return kernels().name;
+}
+
+limb_t limbAdd(limb_t* r, const limb_t* a, const limb_t* b, int n){
+	return kernels().add(r, a, b, n);
+}
+
+limb_t limbSub(limb_t* r, const limb_t* a, const limb_t* b, int n){
+	return kernels().sub(r, a, b, n);
+}
+
+limb_t limbAddMul1(limb_t* r, const limb_t* a, int n, limb_t w){
+	return kernels().addMul1(r, a, n, w);
+}
+
+int limbCmp(const limb_t* a, const limb_t* b, int n){
+	for(int i=n-1; i>=0; i--){
+		if(a[i] != b[i]){
+			return (a[i] > b[i]) ? 1 : -1;
+		}
+	}
+	return 0;
+}
+
+int limbLength(const limb_t* a, int n){
+	while(n > 0 && a[n-1] == 0){
+		n--;
+	}
+	return n;
+}
+
+limb_t limbShl(limb_t* r, const limb_t* a, int n, int bits){
+	if(bits == 0){
+		if(r != a){
+			std::memmove(r, a, n*sizeof(limb_t));
+		}
+		return 0;
+	}
+	limb_t out = 0;
+	//Work from the top down so r may equal a.
+	for(int i=n-1; i>=0; i--){
+		limb_t ai = a[i];
+		if(i == n-1){
+			out = ai >> (LIMB_BITS - bits);
+		}
+		r[i] = (ai << bits) | ((i > 0) ? (a[i-1] >> (LIMB_BITS - bits)) : 0);
+	}
+	return out;
+}
+
+limb_t limbShr(limb_t* r, const limb_t* a, int n, int bits){
+	if(bits == 0){
+		if(r != a){
+			std::memmove(r, a, n*sizeof(limb_t));
+		}
+		return 0;
+	}
+	limb_t out = (n > 0) ? (a[0] << (LIMB_BITS - bits)) : 0;
+	for(int i=0; i<n; i++){
+		r[i] = (a[i] >> bits) | ((i+1 < n) ? (a[i+1] << (LIMB_BITS - bits)) : 0);
+	}
+	return out;
+}
+
+// Schoolbook multiplication, one limbAddMul1 row per limb of b.
+static void mulSchool(limb_t* r, const limb_t* a, int an, const limb_t* b, int bn){
+	r[an] = limbMul1(r, a, an, b[0]);
+	for(int i=1; i<bn; i++){
+		r[an+i] = limbAddMul1(r+i, a, an, b[i]);
+	}
+}
+
+static void mulAt(limb_t*, const limb_t*, int, const limb_t*, int, int);
+static void sqrAt(limb_t*, const limb_t*, int, int);
+
+// Karatsuba for two n-limb operands.  r gets 2n limbs.  The three half-size
+// products are taken at the same cutoff.
+static void mulKaratsuba(limb_t* r, const limb_t* a, const limb_t* b, int n, int cutoff){
+	int k = (n+1)/2;
+	int h = n - k;
+	LimbArena& arena = scratchArena();
+	ArenaScope scope(arena);
+
+	//z0 = a0*b0 into the low 2k limbs, z2 = a1*b1 into the high 2h limbs.
+	mulAt(r, a, k, b, k, cutoff);
+	mulAt(r + 2*k, a + k, h, b + k, h, cutoff);
+
+	//z1 = (a0+a1)(b0+b1) - z0 - z2.
+	limb_t* sa = arena.take(k+1);
+	limb_t* sb = arena.take(k+1);
+	limb_t* z1 = arena.take(2*k+2);
+	std::memcpy(sa, a, k*sizeof(limb_t));
+	std::memcpy(sb, b, k*sizeof(limb_t));
+	//h is k or k-1, so the carry may have one more low limb to ripple through.
+	sa[k] = limbAdd1(sa + h, sa + h, k - h, limbAdd(sa, sa, a + k, h));
+	sb[k] = limbAdd1(sb + h, sb + h, k - h, limbAdd(sb, sb, b + k, h));
+	mulAt(z1, sa, k+1, sb, k+1, cutoff);
+	limb_t borrow = limbSub(z1, z1, r, 2*k);
+	limbSub1(z1 + 2*k, z1 + 2*k, 2, borrow);
+	borrow = limbSub(z1, z1, r + 2*k, 2*h);
+	limbSub1(z1 + 2*h, z1 + 2*h, 2*k + 2 - 2*h, borrow);
+
+	//r += z1 << (64k).  The product fits in 2n limbs, so the top of z1 past
+	//that is zero.
+	int zn = limbLength(z1, 2*k+2);
+	if(zn > 2*n - k){
+		zn = 2*n - k;
+	}
+	limb_t carry = limbAdd(r + k, r + k, z1, zn);
+	limbAdd1(r + k + zn, r + k + zn, 2*n - k - zn, carry);
+}
+
+// limbMul without the check for a square, Karatsuba from cutoff limbs up.
+static void mulAt(limb_t* r, const limb_t* a, int an, const limb_t* b, int bn, int cutoff){
+	if(an < bn){
+		const limb_t* t = a;
+		a = b;
+		b = t;
+		int tn = an;
+		an = bn;
+		bn = tn;
+	}
+	if(bn < cutoff){
+		mulSchool(r, a, an, b, bn);
+		return;
+	}
+	if(an == bn){
+		mulKaratsuba(r, a, b, an, cutoff);
+		return;
+	}
+
+	//Unbalanced: multiply b by bn-limb slices of a and accumulate.
+	LimbArena& arena = scratchArena();
+	ArenaScope scope(arena);
+	limb_t* t = arena.take(2*bn);
+	std::memset(r, 0, (an+bn)*sizeof(limb_t));
+	for(int off=0; off<an; off+=bn){
+		int len = (an - off < bn) ? (an - off) : bn;
+		mulAt(t, a + off, len, b, bn, cutoff);
+		limbAdd(r + off, r + off, t, len + bn);
+	}
+}
+
+void limbMul(limb_t* r, const limb_t* a, int an, const limb_t* b, int bn){
+	if(a == b && an == bn){
+		limbSqr(r, a, an);
+		return;
+	}
+	const Tuning& tuning = Tuning::current();
+	if(an >= tuning.nttMul && bn >= tuning.nttMul){
+		limbMulNTT(r, a, an, b, bn);
+		return;
+	}
+	mulAt(r, a, an, b, bn, tuning.karatsubaMul);
+}
+
+void limbMulCutoff(limb_t* r, const limb_t* a, int an, const limb_t* b, int bn, int cutoff){
+	mulAt(r, a, an, b, bn, cutoff);
+}
+
+// Schoolbook squaring: the cross products above the diagonal, doubled, plus the
+// squares on the diagonal.
+static void sqrSchool(limb_t* r, const limb_t* a, int n){
+	r[0] = 0;
+	r[2*n-1] = 0;
+	if(n > 1){
+		r[n] = limbMul1(r + 1, a + 1, n - 1, a[0]);
+		for(int i=1; i<n-1; i++){
+			r[n+i] = limbAddMul1(r + 2*i + 1, a + i + 1, n - i - 1, a[i]);
+		}
+		limbShl(r, r, 2*n, 1);
+	}
+	limb_t carry = 0;
+	for(int i=0; i<n; i++){
+		dlimb_t sq = (dlimb_t)a[i] * a[i];
+		dlimb_t s = (dlimb_t)r[2*i] + (limb_t)sq + carry;
+		r[2*i] = (limb_t)s;
+		s = (dlimb_t)r[2*i+1] + (limb_t)(sq >> LIMB_BITS) + (limb_t)(s >> LIMB_BITS);
+		r[2*i+1] = (limb_t)s;
+		carry = (limb_t)(s >> LIMB_BITS);
+	}
+}
+
+// Karatsuba squaring, as mulKaratsuba with both operands the same.
+static void sqrKaratsuba(limb_t* r, const limb_t* a, int n, int cutoff){
+	int k = (n+1)/2;
+	int h = n - k;
+	LimbArena& arena = scratchArena();
+	ArenaScope scope(arena);
+
+	sqrAt(r, a, k, cutoff);
+	sqrAt(r + 2*k, a + k, h, cutoff);
+
+	//z1 = (a0+a1)^2 - z0 - z2.
+	limb_t* sa = arena.take(k+1);
+	limb_t* z1 = arena.take(2*k+2);
+	std::memcpy(sa, a, k*sizeof(limb_t));
+	sa[k] = limbAdd1(sa + h, sa + h, k - h, limbAdd(sa, sa, a + k, h));
+	sqrAt(z1, sa, k+1, cutoff);
+	limb_t borrow = limbSub(z1, z1, r, 2*k);
+	limbSub1(z1 + 2*k, z1 + 2*k, 2, borrow);
+	borrow = limbSub(z1, z1, r + 2*k, 2*h);
+	limbSub1(z1 + 2*h, z1 + 2*h, 2*k + 2 - 2*h, borrow);
+
+	int zn = limbLength(z1, 2*k+2);
+	if(zn > 2*n - k){
+		zn = 2*n - k;
+	}
+	limb_t carry = limbAdd(r + k, r + k, z1, zn);
+	limbAdd1(r + k + zn, r + k + zn, 2*n - k - zn, carry);
+}
+
+static void sqrAt(limb_t* r, const limb_t* a, int n, int cutoff){
+	if(n < cutoff){
+		sqrSchool(r, a, n);
+	}
+	else{
+		sqrKaratsuba(r, a, n, cutoff);
+	}
+}
+
+void limbSqr(limb_t* r, const limb_t* a, int n){
+	const Tuning& tuning = Tuning::current();
+	if(n >= tuning.nttSqr){
+		limbMulNTT(r, a, n, a, n);
+		return;
+	}
+	sqrAt(r, a, n, tuning.karatsubaSqr);
+}
+
+void limbSqrCutoff(limb_t* r, const limb_t* a, int n, int cutoff){
+	sqrAt(r, a, n, cutoff);
+}
+
+limb_t limbDivRem1(limb_t* q, const limb_t* a, int n, limb_t w){
+	limb_t rem = 0;
+	for(int i=n-1; i>=0; i--){
+		dlimb_t num = ((dlimb_t)rem << LIMB_BITS) | a[i];
+		limb_t qi = (limb_t)(num / w);
+		rem = (limb_t)(num - (dlimb_t)qi * w);
+		if(q){
+			q[i] = qi;
+		}
+	}
+	return rem;
+}
+
+void limbDivRem(limb_t* q, limb_t* r, const limb_t* a, int an, const limb_t* b, int bn){
+	int qn = an - bn + 1;
+	int n = limbLength(a, an);
+	LimbArena& arena = scratchArena();
+	ArenaScope scope(arena);
+
+	//Dividend smaller than the divisor: quotient 0, remainder a.
+	if(n < bn || (n == bn && limbCmp(a, b, bn) < 0)){
+		if(r){
+			if(r != a){
+				std::memmove(r, a, n*sizeof(limb_t));
+			}
+			std::memset(r + n, 0, (bn - n)*sizeof(limb_t));
+		}
+		if(q && qn > 0){
+			std::memset(q, 0, qn*sizeof(limb_t));
+		}
+		return;
+	}
+
+	if(bn == 1){
+		limb_t rem = limbDivRem1(q, a, n, b[0]);
+		if(q){
+			std::memset(q + n, 0, (qn - n)*sizeof(limb_t));
+		}
+		if(r){
+			r[0] = rem;
+		}
+		return;
+	}
+
+	//Normalize so the divisor's top bit is set.
+	int s = __builtin_clzll(b[bn-1]);
+	limb_t* v = arena.take(bn);
+	limb_t* u = arena.take(n+1);
+	limbShl(v, b, bn, s);
+	u[n] = limbShl(u, a, n, s);
+
+	limb_t vtop = v[bn-1];
+	limb_t vnext = v[bn-2];
+	limb_t* qt = arena.take(n - bn + 1);
+
+	for(int j=n-bn; j>=0; j--){
+		limb_t qhat;
+		dlimb_t rhat;
+		dlimb_t num = ((dlimb_t)u[j+bn] << LIMB_BITS) | u[j+bn-1];
+		if(u[j+bn] >= vtop){
+			qhat = ~(limb_t)0;
+			rhat = num - (dlimb_t)qhat * vtop;
+		}
+		else{
+			qhat = (limb_t)(num / vtop);
+			rhat = num - (dlimb_t)qhat * vtop;
+		}
+		//Correct the estimate using the second divisor limb; at most twice.
+		while((rhat >> LIMB_BITS) == 0 &&
+				(dlimb_t)qhat * vnext > ((rhat << LIMB_BITS) | u[j+bn-2])){
+			qhat--;
+			rhat += vtop;
+		}
+		limb_t borrow = limbSubMul1(u + j, v, bn, qhat);
+		limb_t top = u[j+bn];
+		u[j+bn] = top - borrow;
+		if(top < borrow){
+			//Estimate was one too large: add the divisor back.
+			qhat--;
+			limb_t carry = limbAdd(u + j, u + j, v, bn);
+			u[j+bn] += carry;
+		}
+		qt[j] = qhat;
+	}
+
+	if(q){
+		std::memcpy(q, qt, (n - bn + 1)*sizeof(limb_t));
+		std::memset(q + (n - bn + 1), 0, (qn - (n - bn + 1))*sizeof(limb_t));
+	}
+	if(r){
+		limbShr(r, u, bn, s);
+	}
+}
+
+limb_t wordMulMod(limb_t a, limb_t b, limb_t m){
+	if(m >> 32 == 0){
+		return ((a % m) * (b % m)) % m;
+	}
+	return (limb_t)(((dlimb_t)a * b) % m);
+}
+
+limb_t wordPowMod(limb_t a, const limb_t* e, int en, limb_t m){
+	limb_t result = 1 % m;
+	a %= m;
+	en = limbLength(e, en);
+	if(en == 0){
+		return result;
+	}
+	//Left to right from the bit below the top one, which is taken by result = a.
+	result = a;
+	int top = LIMB_BITS - 1 - __builtin_clzll(e[en-1]);
+	for(int i=en-1; i>=0; i--){
+		for(int bit=(i == en-1) ? top-1 : LIMB_BITS-1; bit>=0; bit--){
+			result = wordMulMod(result, result, m);
+			if((e[i] >> bit) & 1){
+				result = wordMulMod(result, a, m);
+			}
+		}
+	}
+	return result;
+}
+
+limb_t wordGcd(limb_t a, limb_t b){
+	if(a == 0){
+		return b;
+	}
+	if(b == 0){
+		return a;
+	}
+	int shift = __builtin_ctzll(a | b);
+	a >>= __builtin_ctzll(a);
+	while(b != 0){
+		b >>= __builtin_ctzll(b);
+		if(a > b){
+			limb_t t = a;
+			a = b;
+			b = t;
+		}
+		b -= a;
+	}
+	return a << shift;
+}
+
+limb_t wordModInverse(limb_t a, limb_t m){
+	//Extended Euclid on (m, a), with the coefficients of a kept mod m.
+	limb_t r0 = m, r1 = a % m;
+	limb_t s0 = 0, s1 = 1 % m;
+	while(r1 != 0){
+		limb_t q = r0 / r1;
+		limb_t r = r0 - q*r1;
+		//s2 = s0 - q*s1 mod m
+		limb_t qs = wordMulMod(q % m, s1, m);
+		limb_t s = (s0 >= qs) ? s0 - qs : s0 + (m - qs);
+		r0 = r1;
+		r1 = r;
+		s0 = s1;
+		s1 = s;
+	}
+	return (r0 == 1) ? s0 : 0;
+}
+
+}
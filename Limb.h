@@ -0,0 +1,235 @@
+#ifndef LIMB_H_
+#define LIMB_H_
+
+namespace RSAUtil
+{
+	/*
+	 * **********************************************************************************
+	 * Limb-level arithmetic kernels.  The arbitrary precision types store their
+	 * magnitude as an array of 64 bit limbs, least significant limb first.  Every
+	 * routine in this file works on raw limb arrays so that callers can run them
+	 * over inline storage, pooled storage or scratch space from the per-thread arena
+	 * (see LimbAllocator.h) without any copying or allocation of their own.
+	 *
+	 * Unless stated otherwise the result array may be the same as an input array,
+	 * but must not partially overlap one.
+	 *
+	 * @file: Limb.h
+	 * @namespace: RSAUtil
+	 * @version: 1.0.0.0
+	 * @date: 10/18/2026
+	 * **********************************************************************************
+	 */
+
+	typedef unsigned long long limb_t;
+	typedef unsigned __int128 dlimb_t;
+
+	#define LIMB_BITS 64
+
+	//Environment variable that overrides the kernel variant picked at startup
+	//(see limbKernelName).
+	#define LIMB_KERNELS_ENV "RSAUTIL_LIMB_KERNELS"
+
+	//Operands of at least this many limbs are multiplied with Karatsuba, unless a
+	//tuning file says otherwise (see Tuning.h).
+	#define LIMB_KARATSUBA_CUTOFF 32
+
+	//Products with both operands, and squares, of at least this many limbs go
+	//through limbMulNTT, unless a tuning file says otherwise.
+	#define LIMB_NTT_MUL_CUTOFF 16384
+	#define LIMB_NTT_SQR_CUTOFF 8192
+
+	/*
+	 * *********************************************************************************
+	 * limbKernelName.	limbAdd, limbSub and limbAddMul1 (the rows of every
+	 * 				schoolbook product and Montgomery reduction) have variants for
+	 * 				different CPUs, one of which is picked through CPUID on first use:
+	 * 				"adx" (BMI2 mulx with ADX adcx/adox carry chains), "x86-64" (adc/sbb
+	 * 				chains) or "portable" (plain C++).  Setting LIMB_KERNELS_ENV to
+	 * 				"x86-64" or "portable" forces that variant instead, e.g. for
+	 * 				benchmarking; a variant the CPU lacks is never used.
+	 * @returns const char*:	The name of the variant in use.
+	 * *********************************************************************************
+	 */
+	const char* limbKernelName();
+
+	/*
+	 * *********************************************************************************
+	 * limbAdd.	r = a + b, all three arrays of the given length.
+	 * @returns limb_t:	The carry out (0 or 1).
+	 * *********************************************************************************
+	 */
+	limb_t limbAdd(limb_t*, const limb_t*, const limb_t*, int);
+
+	/*
+	 * *********************************************************************************
+	 * limbAdd1.	r = a + w, where w is a single limb.
+	 * @returns limb_t:	The carry out (0 or 1).
+	 * *********************************************************************************
+	 */
+	limb_t limbAdd1(limb_t*, const limb_t*, int, limb_t);
+
+	/*
+	 * *********************************************************************************
+	 * limbSub.	r = a - b, all three arrays of the given length.
+	 * @returns limb_t:	The borrow out (0 or 1).
+	 * *********************************************************************************
+	 */
+	limb_t limbSub(limb_t*, const limb_t*, const limb_t*, int);
+
+	/*
+	 * *********************************************************************************
+	 * limbSub1.	r = a - w, where w is a single limb.
+	 * @returns limb_t:	The borrow out (0 or 1).
+	 * *********************************************************************************
+	 */
+	limb_t limbSub1(limb_t*, const limb_t*, int, limb_t);
+
+	/*
+	 * *********************************************************************************
+	 * limbMul1.	r = a * w, where w is a single limb.
+	 * @returns limb_t:	The high limb of the product.
+	 * *********************************************************************************
+	 */
+	limb_t limbMul1(limb_t*, const limb_t*, int, limb_t);
+
+	/*
+	 * *********************************************************************************
+	 * limbAddMul1.	r += a * w, where w is a single limb.  This is one row of a
+	 * 				schoolbook multiplication.
+	 * @returns limb_t:	The limb carried out of r.
+	 * *********************************************************************************
+	 */
+	limb_t limbAddMul1(limb_t*, const limb_t*, int, limb_t);
+
+	/*
+	 * *********************************************************************************
+	 * limbSubMul1.	r -= a * w, where w is a single limb.
+	 * @returns limb_t:	The limb borrowed out of r.
+	 * *********************************************************************************
+	 */
+	limb_t limbSubMul1(limb_t*, const limb_t*, int, limb_t);
+
+	/*
+	 * *********************************************************************************
+	 * limbCmp.	Unsigned comparison of two arrays of the given length.
+	 * @returns int:	-1, 0 or 1 as a is less than, equal to or greater than b.
+	 * *********************************************************************************
+	 */
+	int limbCmp(const limb_t*, const limb_t*, int);
+
+	/*
+	 * *********************************************************************************
+	 * limbLength.	Number of significant limbs, i.e. the given length less any
+	 * 				leading zero limbs.
+	 * *********************************************************************************
+	 */
+	int limbLength(const limb_t*, int);
+
+	/*
+	 * *********************************************************************************
+	 * limbShl / limbShr.	Shift an array left or right by 0-63 bits.
+	 * @returns limb_t:	The bits shifted out, aligned to the low (shl) or high (shr)
+	 * 					end of the returned limb.
+	 * *********************************************************************************
+	 */
+	limb_t limbShl(limb_t*, const limb_t*, int, int);
+	limb_t limbShr(limb_t*, const limb_t*, int, int);
+
+	/*
+	 * *********************************************************************************
+	 * limbMul.	r = a * b.  r must hold an + bn limbs and must not overlap either
+	 * 			operand.  Balanced operands of Tuning::karatsubaMul limbs or more use
+	 * 			Karatsuba, with scratch space taken from the per-thread arena, and
+	 * 			operands both of Tuning::nttMul limbs or more use limbMulNTT.  A
+	 * 			square (the same array passed twice) goes to limbSqr.
+	 * @parameter limb_t*:	The product, an + bn limbs.
+	 * @parameter const limb_t*, int:	The first operand and its length (>= 1).
+	 * @parameter const limb_t*, int:	The second operand and its length (>= 1).
+	 * *********************************************************************************
+	 */
+	void limbMul(limb_t*, const limb_t*, int, const limb_t*, int);
+
+	/*
+	 * *********************************************************************************
+	 * limbSqr.	r = a * a.  Each cross product a[i]*a[j] is formed once and doubled,
+	 * 			which is about half the work of limbMul(r, a, n, a, n).  Same rules
+	 * 			for r as limbMul; the Karatsuba cutoff is Tuning::karatsubaSqr and
+	 * 			the NTT one Tuning::nttSqr.
+	 * @parameter limb_t*:	The square, 2n limbs.
+	 * @parameter const limb_t*, int:	The operand and its length (>= 1).
+	 * *********************************************************************************
+	 */
+	void limbSqr(limb_t*, const limb_t*, int);
+
+	/*
+	 * *********************************************************************************
+	 * limbMulCutoff / limbSqrCutoff.	limbMul and limbSqr with the Karatsuba cutoff
+	 * 				given as the last argument instead of the tuned one, for the tuner
+	 * 				and benchmarks.  They never use limbMulNTT, and limbMulCutoff does
+	 * 				not check for a square.
+	 * *********************************************************************************
+	 */
+	void limbMulCutoff(limb_t*, const limb_t*, int, const limb_t*, int, int);
+	void limbSqrCutoff(limb_t*, const limb_t*, int, int);
+
+	/*
+	 * *********************************************************************************
+	 * limbMulNTT.	r = a * b by number-theoretic transforms mod three 62 bit primes,
+	 * 				with the product's coefficients put back together by the Chinese
+	 * 				remainder theorem.  Takes O(n log n) time against Karatsuba's
+	 * 				O(n^1.58), but with large constants: limbMul and limbSqr only use
+	 * 				it from Tuning::nttMul and Tuning::nttSqr limbs up.  Same rules
+	 * 				for r as limbMul; a square is detected and transformed once.  The
+	 * 				transforms take about 5(an + bn) limbs of heap memory.
+	 * @parameter limb_t*:	The product, an + bn limbs.
+	 * @parameter const limb_t*, int:	The first operand and its length (>= 1).
+	 * @parameter const limb_t*, int:	The second operand and its length (>= 1).
+	 * *********************************************************************************
+	 */
+	void limbMulNTT(limb_t*, const limb_t*, int, const limb_t*, int);
+
+	/*
+	 * *********************************************************************************
+	 * limbDivRem1.	Divides a by the single limb w.  The quotient array may be null.
+	 * @returns limb_t:	The remainder.
+	 * *********************************************************************************
+	 */
+	limb_t limbDivRem1(limb_t*, const limb_t*, int, limb_t);
+
+	/*
+	 * *********************************************************************************
+	 * limbDivRem.	Long division (Knuth, algorithm D).  Divides the an-limb array a
+	 * 				by the bn-limb array b, whose top limb must be non-zero.  The
+	 * 				quotient gets an - bn + 1 limbs (or is skipped if null, or is all
+	 * 				zero if an < bn) and the remainder gets bn limbs.  Normalized copies
+	 * 				of the operands are kept in the per-thread arena, so the outputs may
+	 * 				alias the inputs.
+	 * @parameter limb_t*:	The quotient, or null.
+	 * @parameter limb_t*:	The remainder, or null.
+	 * @parameter const limb_t*, int:	The dividend and its length.
+	 * @parameter const limb_t*, int:	The divisor and its length (>= 1).
+	 * *********************************************************************************
+	 */
+	void limbDivRem(limb_t*, limb_t*, const limb_t*, int, const limb_t*, int);
+
+	/*
+	 * *********************************************************************************
+	 * Single word kernels.  Moduli that fit in one limb (every key the original
+	 * 96 bit code can build) skip the array code and work on native 64 and 128 bit
+	 * integers.  The modulus must be non-zero.
+	 *
+	 * wordMulMod.	[a*b] mod m.
+	 * wordPowMod.	[a^e] mod m, where the exponent is an en-limb array (en may be 0).
+	 * wordGcd.	gcd(a, b), by the binary algorithm.
+	 * wordModInverse.	b with [a*b] mod m = 1, or 0 if a is not invertible mod m.
+	 * *********************************************************************************
+	 */
+	limb_t wordMulMod(limb_t, limb_t, limb_t);
+	limb_t wordPowMod(limb_t, const limb_t*, int, limb_t);
+	limb_t wordGcd(limb_t, limb_t);
+	limb_t wordModInverse(limb_t, limb_t);
+
+}
+
+#endif /*LIMB_H_*/
@@ -0,0 +1,197 @@
+#include "LimbAllocator.h"
+#include <cstddef>
+
+namespace RSAUtil
+{
+
+LimbAllocator::~LimbAllocator()
+{
+}
+
+bool LimbAllocator::isScoped() const{
+	return false;
+}
+
+limb_t* HeapAllocator::allocate(int& count){
+	return new limb_t[count];
+}
+
+void HeapAllocator::release(limb_t* block, int){
+	delete[] block;
+}
+
+/*
+ * Per-thread free lists for LimbPool.  A free block stores the pointer to the
+ * next free block in its first limb, so keeping a list costs no memory of its own.
+ */
+struct PoolLists
+{
+	limb_t* head[LIMBPOOL_CLASSES];
+	int depth[LIMBPOOL_CLASSES];
+
+	PoolLists(){
+		for(int i=0; i<LIMBPOOL_CLASSES; i++){
+			head[i] = 0;
+			depth[i] = 0;
+		}
+	}
+
+	~PoolLists(){
+		for(int i=0; i<LIMBPOOL_CLASSES; i++){
+			while(head[i]){
+				limb_t* next = (limb_t*)(size_t)head[i][0];
+				delete[] head[i];
+				head[i] = next;
+			}
+		}
+	}
+};
+
+static thread_local PoolLists poolLists;
+
+//Size class for a request, or -1 if it is too big to pool.
+static int poolClass(int count){
+	int c = 0;
+	int size = 8;
+	while(size < count){
+		size <<= 1;
+		c++;
+	}
+	return (c < LIMBPOOL_CLASSES) ? c : -1;
+}
+
+limb_t* LimbPool::allocate(int& count){
+	int c = poolClass(count);
+	if(c < 0){
+		return new limb_t[count];
+	}
+	count = 8 << c;
+	limb_t* block = poolLists.head[c];
+	if(block){
+		poolLists.head[c] = (limb_t*)(size_t)block[0];
+		poolLists.depth[c]--;
+		return block;
+	}
+	return new limb_t[count];
+}
+
+void LimbPool::release(limb_t* block, int count){
+	int c = poolClass(count);
+	//Only exact class sizes came from the pool; anything else was a plain new[].
+	if(c < 0 || (8 << c) != count || poolLists.depth[c] >= LIMBPOOL_DEPTH){
+		delete[] block;
+		return;
+	}
+	block[0] = (limb_t)(size_t)poolLists.head[c];
+	poolLists.head[c] = block;
+	poolLists.depth[c]++;
+}
+
+LimbArena::LimbArena(){
+	current = 0;
+	offset = 0;
+	blockSize = LIMBARENA_BLOCK;
+}
+
+LimbArena::LimbArena(int blockLimbs){
+	current = 0;
+	offset = 0;
+	blockSize = blockLimbs;
+}
+
+LimbArena::~LimbArena(){
+	for(size_t i=0; i<blocks.size(); i++){
+		delete[] blocks[i].base;
+	}
+}
+
+limb_t* LimbArena::allocate(int& count){
+	limb_t* response;
+
+	if(current < (int)blocks.size() && offset + count <= blocks[current].size){
+		response = blocks[current].base + offset;
+		offset += count;
+		return response;
+	}
+	//Move on to the first later block that is big enough, keeping the blocks in
+	//between for the next time the arena is rewound past them.
+	for(int i=current+1; i<(int)blocks.size(); i++){
+		if(count <= blocks[i].size){
+			current = i;
+			offset = count;
+			return blocks[i].base;
+		}
+	}
+	Block b;
+	b.size = (count > blockSize) ? count : blockSize;
+	b.base = new limb_t[b.size];
+	blocks.push_back(b);
+	current = blocks.size() - 1;
+	offset = count;
+	return b.base;
+}
+
+void LimbArena::release(limb_t* block, int count){
+	if(current < (int)blocks.size() && block + count == blocks[current].base + offset
+			&& block >= blocks[current].base){
+		offset -= count;
+	}
+}
+
+bool LimbArena::isScoped() const{
+	return true;
+}
+
+limb_t* LimbArena::take(int count){
+	return allocate(count);
+}
+
+LimbArena::Mark LimbArena::mark() const{
+	Mark m;
+	m.block = current;
+	m.offset = offset;
+	return m;
+}
+
+void LimbArena::rewind(Mark m){
+	current = m.block;
+	offset = m.offset;
+}
+
+long LimbArena::reserved() const{
+	long total = 0;
+	for(size_t i=0; i<blocks.size(); i++){
+		total += blocks[i].size;
+	}
+	return total;
+}
+
+ArenaScope::ArenaScope(LimbArena& arena) : a(arena){
+	m = a.mark();
+}
+
+ArenaScope::~ArenaScope(){
+	a.rewind(m);
+}
+
+LimbArena& ArenaScope::arena() const{
+	return a;
+}
+
+static LimbPool defaultPool;
+static LimbAllocator* currentDefault = &defaultPool;
+
+LimbAllocator* defaultAllocator(){
+	return currentDefault;
+}
+
+void setDefaultAllocator(LimbAllocator* alloc){
+	currentDefault = alloc ? alloc : &defaultPool;
+}
+
+LimbArena& scratchArena(){
+	static thread_local LimbArena arena;
+	return arena;
+}
+
+}
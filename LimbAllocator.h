@@ -0,0 +1,186 @@
+#ifndef LIMBALLOCATOR_H_
+#define LIMBALLOCATOR_H_
+#include <vector>
+#include "Limb.h"
+
+namespace RSAUtil
+{
+	//Largest pooled block is 8 << (LIMBPOOL_CLASSES-1) limbs; bigger ones go to the heap.
+	#define LIMBPOOL_CLASSES 16
+	//Number of free blocks each thread keeps per size class.
+	#define LIMBPOOL_DEPTH 32
+	//Default size of one arena block, in limbs.
+	#define LIMBARENA_BLOCK 8192
+
+	/*
+	 * **********************************************************************************
+	 * Storage for limb arrays that do not fit inline in a BigNum.  A BigNum asks its
+	 * allocator for storage only when it spills, so the allocator can be chosen per
+	 * value: the process default (a LimbPool), a caller supplied pool, or an arena
+	 * for temporaries whose lifetime is a single operation.
+	 *
+	 * @class: LimbAllocator
+	 * @namespace: RSAUtil
+	 * @file: LimbAllocator.h
+	 * @version: 1.0.0.0
+	 * @date: 10/18/2026
+	 * **********************************************************************************
+	 */
+class LimbAllocator
+{
+public:
+	virtual ~LimbAllocator();
+
+	/*
+	 * *******************************************************************************
+	 * allocate.	Returns storage for at least the requested number of limbs.
+	 * @parameter int&:	The number of limbs requested.  On return it holds the number
+	 * 					of limbs actually granted, which may be larger.
+	 * @returns limb_t*:	The storage.
+	 * *******************************************************************************
+	 */
+	virtual limb_t* allocate(int&) = 0;
+
+	/*
+	 * *******************************************************************************
+	 * release.	Gives back storage obtained from allocate().
+	 * @parameter limb_t*:	The storage.
+	 * @parameter int:	The number of limbs granted by allocate().
+	 * *******************************************************************************
+	 */
+	virtual void release(limb_t*, int) = 0;
+
+	/*
+	 * *******************************************************************************
+	 * isScoped.	True if the allocator reclaims its memory in bulk (an arena).  A
+	 * 				value backed by such an allocator must not outlive the scope that
+	 * 				created it, so copies and moves of it switch to the default
+	 * 				allocator.
+	 * *******************************************************************************
+	 */
+	virtual bool isScoped() const;
+};
+
+/*
+ * **************************************************************************************
+ * Plain operator new / delete.
+ * **************************************************************************************
+ */
+class HeapAllocator : public LimbAllocator
+{
+public:
+	limb_t* allocate(int&);
+	void release(limb_t*, int);
+};
+
+/*
+ * **************************************************************************************
+ * A size-classed pool.  Requests are rounded up to a power of two (8 limbs at
+ * least) and released blocks are kept on per-thread free lists, so a thread that
+ * keeps working with numbers of the same sizes stops touching the heap once its
+ * lists are warm.  Blocks carry no owner, so a value may be freed by a different
+ * thread than the one that allocated it.
+ * **************************************************************************************
+ */
+class LimbPool : public LimbAllocator
+{
+public:
+	limb_t* allocate(int&);
+	void release(limb_t*, int);
+};
+
+/*
+ * **************************************************************************************
+ * A bump allocator for scratch space.  Memory is handed out in stack order from a
+ * list of blocks that are kept between uses; mark() and rewind() (usually through
+ * an ArenaScope) give everything allocated since the mark back at once.  An arena
+ * is not thread-safe: each thread uses its own through scratchArena().
+ *
+ * Anything that writes its result into arena-backed storage owned by a caller must
+ * size that storage before it opens a scope of its own, otherwise growing the
+ * caller's storage would hand out memory that the inner scope then rewinds.
+ * **************************************************************************************
+ */
+class LimbArena : public LimbAllocator
+{
+public:
+	struct Mark
+	{
+		int block;
+		int offset;
+	};
+
+	LimbArena();
+	LimbArena(int);
+	~LimbArena();
+
+	limb_t* allocate(int&);
+	//Only the most recent allocation is actually reclaimed; anything else waits
+	//for rewind().
+	void release(limb_t*, int);
+	bool isScoped() const;
+
+	//Convenience form of allocate() for a fixed number of limbs.
+	limb_t* take(int);
+
+	Mark mark() const;
+	void rewind(Mark);
+
+	//Total number of limbs held in blocks, used or not.
+	long reserved() const;
+
+private:
+	struct Block
+	{
+		limb_t* base;
+		int size;
+	};
+	std::vector<Block> blocks;
+	int current;
+	int offset;
+	int blockSize;
+
+	LimbArena(const LimbArena&);
+	LimbArena& operator=(const LimbArena&);
+};
+
+/*
+ * **************************************************************************************
+ * Marks an arena on construction and rewinds it on destruction.
+ * **************************************************************************************
+ */
+class ArenaScope
+{
+public:
+	ArenaScope(LimbArena&);
+	~ArenaScope();
+	LimbArena& arena() const;
+private:
+	LimbArena& a;
+	LimbArena::Mark m;
+
+	ArenaScope(const ArenaScope&);
+	ArenaScope& operator=(const ArenaScope&);
+};
+
+/*
+ * *********************************************************************************
+ * defaultAllocator.	The allocator new BigNums spill to.  This is a LimbPool
+ * 						unless replaced with setDefaultAllocator().  The allocator
+ * 						must outlive every value that uses it.
+ * *********************************************************************************
+ */
+LimbAllocator* defaultAllocator();
+void setDefaultAllocator(LimbAllocator*);
+
+/*
+ * *********************************************************************************
+ * scratchArena.	The calling thread's arena, used by the limb kernels and by
+ * 					modPow, modInverse, gcd and division for their temporaries.
+ * *********************************************************************************
+ */
+LimbArena& scratchArena();
+
+}
+
+#endif /*LIMBALLOCATOR_H_*/
@@ -0,0 +1,243 @@
+#include "Limb.h"
+#include <cstring>
+#include <vector>
+
+namespace RSAUtil
+{
+
+//Three primes p = c*2^50 + 1 just below 2^62, with a primitive root of each.  Their
+//product is above 2^185, so every coefficient of a product of operands shorter than
+//2^31 limbs, which is below 2^159, is fixed by its residues; and 2^50 bounds the
+//transform length far above anything an int can index.
+#define NTT_PRIMES 3
+static const limb_t nttModulus[NTT_PRIMES] = {
+	4601552919265804289ULL, 4546383823830515713ULL, 4522739925786820609ULL};
+static const limb_t nttGenerator[NTT_PRIMES] = {3, 10, 37};
+
+// Arithmetic mod one prime.  Products go through Montgomery reduction with R = 2^64;
+// the transforms keep their data as plain residues and their constants in
+// Montgomery form, so mul(x, yR) is just x*y mod p.
+struct NttPrime
+{
+	limb_t p;
+	//-p^-1 mod 2^64.
+	limb_t pinv;
+	//R^2 mod p.
+	limb_t r2;
+
+	//t*R^-1 mod p, for t < p*2^64.
+	inline limb_t redc(dlimb_t t) const{
+		limb_t m = (limb_t)t * pinv;
+		limb_t u = (limb_t)((t + (dlimb_t)m * p) >> LIMB_BITS);
+		return (u >= p) ? u - p : u;
+	}
+	inline limb_t mul(limb_t a, limb_t b) const{
+		return redc((dlimb_t)a * b);
+	}
+	inline limb_t add(limb_t a, limb_t b) const{
+		limb_t s = a + b;
+		return (s >= p) ? s - p : s;
+	}
+	inline limb_t sub(limb_t a, limb_t b) const{
+		return (a >= b) ? a - b : a + p - b;
+	}
+	inline limb_t toMont(limb_t a) const{
+		return redc((dlimb_t)a * r2);
+	}
+	//a^e mod p in Montgomery form, for a in Montgomery form.
+	limb_t pow(limb_t a, limb_t e) const{
+		limb_t x = toMont(1);
+		while(e){
+			if(e & 1){
+				x = mul(x, a);
+			}
+			a = mul(a, a);
+			e >>= 1;
+		}
+		return x;
+	}
+	//a^-1 mod p in Montgomery form, for a plain a.
+	limb_t inverse(limb_t a) const{
+		return pow(toMont(a % p), p - 2);
+	}
+};
+
+// The primes and the constants of the CRT reconstruction (see coefficient).
+struct NttConstants
+{
+	NttPrime prime[NTT_PRIMES];
+	//p0^-1 mod p1, (p0*p1)^-1 mod p2 and p0 mod p2, in Montgomery form.
+	limb_t inv01;
+	limb_t inv012;
+	limb_t p0mod2;
+	//p0*p1, low and high limb.
+	limb_t p01Low;
+	limb_t p01High;
+};
+
+static NttConstants makeConstants(){
+	NttConstants c;
+	for(int k=0; k<NTT_PRIMES; k++){
+		NttPrime& q = c.prime[k];
+		q.p = nttModulus[k];
+		//Newton's iteration for p^-1 mod 2^64, from p*p = 1 mod 8.
+		limb_t inv = q.p;
+		for(int i=0; i<5; i++){
+			inv *= 2 - q.p * inv;
+		}
+		q.pinv = 0 - inv;
+		limb_t r = (limb_t)((((dlimb_t)1) << LIMB_BITS) % q.p);
+		q.r2 = (limb_t)(((dlimb_t)r * r) % q.p);
+	}
+	const NttPrime& p1 = c.prime[1];
+	const NttPrime& p2 = c.prime[2];
+	dlimb_t p01 = (dlimb_t)c.prime[0].p * p1.p;
+	c.inv01 = p1.inverse(c.prime[0].p);
+	c.inv012 = p2.inverse((limb_t)(p01 % p2.p));
+	c.p0mod2 = p2.toMont(c.prime[0].p % p2.p);
+	c.p01Low = (limb_t)p01;
+	c.p01High = (limb_t)(p01 >> LIMB_BITS);
+	return c;
+}
+
+static const NttConstants& constants(){
+	static const NttConstants c = makeConstants();
+	return c;
+}
+
+// Twiddle factors for a transform of length n, in Montgomery form: w[len + j] is
+// the j-th power of a primitive 2len-th root of unity (of its inverse if inverse is
+// set), for every power of two len < n and j < len.
+static void twiddles(limb_t* w, int n, const NttPrime& q, limb_t generator, bool inverse){
+	limb_t g = q.toMont(generator);
+	if(inverse){
+		g = q.pow(g, q.p - 2);
+	}
+	for(int len=1; len<n; len*=2){
+		limb_t root = q.pow(g, (q.p - 1) / (2*(limb_t)len));
+		w[len] = q.toMont(1);
+		for(int j=1; j<len; j++){
+			w[len + j] = q.mul(w[len + j - 1], root);
+		}
+	}
+}
+
+// Forward transform by decimation in frequency: natural order in, bit-reversed
+// order out.
+static void forward(limb_t* a, int n, const limb_t* w, const NttPrime& q){
+	for(int len=n/2; len>=1; len/=2){
+		for(int start=0; start<n; start+=2*len){
+			limb_t* x = a + start;
+			limb_t* y = x + len;
+			for(int j=0; j<len; j++){
+				limb_t u = x[j];
+				limb_t v = y[j];
+				x[j] = q.add(u, v);
+				y[j] = q.mul(q.sub(u, v), w[len + j]);
+			}
+		}
+	}
+}
+
+// Inverse transform by decimation in time, without the division by n: bit-reversed
+// order in, natural order out.
+static void inverse(limb_t* a, int n, const limb_t* w, const NttPrime& q){
+	for(int len=1; len<n; len*=2){
+		for(int start=0; start<n; start+=2*len){
+			limb_t* x = a + start;
+			limb_t* y = x + len;
+			for(int j=0; j<len; j++){
+				limb_t u = x[j];
+				limb_t v = q.mul(y[j], w[len + j]);
+				x[j] = q.add(u, v);
+				y[j] = q.sub(u, v);
+			}
+		}
+	}
+}
+
+// Residues mod q of an operand, zero-padded to n.
+static void load(limb_t* f, int n, const limb_t* a, int an, const NttPrime& q){
+	for(int i=0; i<an; i++){
+		f[i] = a[i] % q.p;
+	}
+	std::memset(f + an, 0, (n - an)*sizeof(limb_t));
+}
+
+// One coefficient from its three residues, by Garner's method:
+// x = x0 + p0*v1 + p0*p1*v2, with v1 < p1 and v2 < p2.  Returned in three limbs.
+static inline void coefficient(limb_t* out, limb_t x0, limb_t x1, limb_t x2, const NttConstants& c){
+	const NttPrime& p1 = c.prime[1];
+	const NttPrime& p2 = c.prime[2];
+	//All three primes lie between 2^61 and 2^62, so x0 < p0 < 2*p1 and 2*p2.
+	limb_t v1 = p1.mul(p1.sub(x1, (x0 >= p1.p) ? x0 - p1.p : x0), c.inv01);
+	limb_t low = p2.add((x0 >= p2.p) ? x0 - p2.p : x0, p2.mul(v1, c.p0mod2));
+	limb_t v2 = p2.mul(p2.sub(x2, low), c.inv012);
+
+	dlimb_t x = (dlimb_t)c.prime[0].p * v1 + x0;
+	dlimb_t t = (dlimb_t)c.p01Low * v2 + (limb_t)x;
+	out[0] = (limb_t)t;
+	t = (dlimb_t)c.p01High * v2 + (limb_t)(x >> LIMB_BITS) + (limb_t)(t >> LIMB_BITS);
+	out[1] = (limb_t)t;
+	out[2] = (limb_t)(t >> LIMB_BITS);
+}
+
+void limbMulNTT(limb_t* r, const limb_t* a, int an, const limb_t* b, int bn){
+	const NttConstants& c = constants();
+	bool square = (a == b && an == bn);
+	int coefficients = an + bn - 1;
+	int n = 1;
+	while(n < coefficients){
+		n *= 2;
+	}
+	std::vector<limb_t> residues(NTT_PRIMES*(size_t)n);
+	std::vector<limb_t> other(square ? 0 : n);
+	std::vector<limb_t> w(n);
+
+	//The product's coefficients mod each prime: transform, multiply pointwise,
+	//transform back.
+	for(int k=0; k<NTT_PRIMES; k++){
+		const NttPrime& q = c.prime[k];
+		limb_t* fa = &residues[k*(size_t)n];
+		load(fa, n, a, an, q);
+		twiddles(&w[0], n, q, nttGenerator[k], false);
+		forward(fa, n, &w[0], q);
+		//mul() leaves a factor R^-1 on the pointwise products; this takes it out
+		//along with the n the inverse transform leaves in.
+		limb_t scale = q.mul(q.inverse(n), q.r2);
+		if(square){
+			for(int i=0; i<n; i++){
+				fa[i] = q.mul(q.mul(fa[i], fa[i]), scale);
+			}
+		}
+		else{
+			limb_t* fb = &other[0];
+			load(fb, n, b, bn, q);
+			forward(fb, n, &w[0], q);
+			for(int i=0; i<n; i++){
+				fa[i] = q.mul(q.mul(fa[i], fb[i]), scale);
+			}
+		}
+		twiddles(&w[0], n, q, nttGenerator[k], true);
+		inverse(fa, n, &w[0], q);
+	}
+
+	//Coefficient i is worth 2^(64i).  A coefficient is below 2^159, so the running
+	//sum shifted down past r[i] always fits in two limbs.
+	const limb_t* x0 = &residues[0];
+	const limb_t* x1 = &residues[n];
+	const limb_t* x2 = &residues[2*(size_t)n];
+	limb_t carry[2] = {0, 0};
+	for(int i=0; i<coefficients; i++){
+		limb_t x[3];
+		coefficient(x, x0[i], x1[i], x2[i], c);
+		dlimb_t s = (dlimb_t)carry[0] + x[0];
+		r[i] = (limb_t)s;
+		s = (dlimb_t)carry[1] + x[1] + (limb_t)(s >> LIMB_BITS);
+		carry[0] = (limb_t)s;
+		carry[1] = x[2] + (limb_t)(s >> LIMB_BITS);
+	}
+	r[coefficients] = carry[0];
+}
+
+}
@@ -0,0 +1,160 @@
+#include "ModInt.h"
+#include <cstring>
+
+namespace RSAUtil
+{
+
+ModInt::ModInt()
+{
+}
+
+ModInt::ModInt(const std::shared_ptr<const MontContext>& context, const BigNum& value)
+	: ctx(context)
+{
+	int nl = ctx->limbs();
+	LimbArena& arena = scratchArena();
+	ArenaScope scope(arena);
+	limb_t* r = arena.take(nl);
+	ctx->toMont(r, value);
+	mont.setLimbs(r, nl);
+}
+
+// The residue is already in Montgomery form; it is below R, so one division at most
+// brings it below n, which is cheaper than the two REDCs of going out and back in.
+ModInt::ModInt(const std::shared_ptr<const MontContext>& context, const limb_t* r, int nl)
+	: ctx(context)
+{
+	mont.setLimbs(r, nl);
+	if(mont >= ctx->getModulus()){
+		mont = mont % ctx->getModulus();
+	}
+}
+
+ModInt::~ModInt()
+{
+}
+
+const std::shared_ptr<const MontContext>& ModInt::getContext() const{
+	return ctx;
+}
+
+// Copies a value below R into limbs() limbs, zero-padding the top.
+void ModInt::load(limb_t* r, const BigNum& a) const{
+	int nl = ctx->limbs();
+	std::memset(r, 0, nl*sizeof(limb_t));
+	std::memcpy(r, a.limbs(), a.size()*sizeof(limb_t));
+}
+
+BigNum ModInt::value() const{
+	LimbArena& arena = scratchArena();
+	ArenaScope scope(arena);
+	limb_t* a = arena.take(ctx->limbs());
+	load(a, mont);
+	return ctx->fromMont(a);
+}
+
+bool ModInt::isZero() const{
+	return mont.isZero();
+}
+
+ModInt ModInt::operator+(const ModInt& b) const{
+	ModInt response(*this);
+	response += b;
+	return response;
+}
+
+ModInt ModInt::operator-(const ModInt& b) const{
+	ModInt response(*this);
+	response -= b;
+	return response;
+}
+
+ModInt ModInt::operator*(const ModInt& b) const{
+	ModInt response(*this);
+	response *= b;
+	return response;
+}
+
+// Montgomery form is linear, so sums and differences need no conversion.
+ModInt& ModInt::operator+=(const ModInt& b){
+	mont += b.mont;
+	if(mont >= ctx->getModulus()){
+		mont -= ctx->getModulus();
+	}
+	return *this;
+}
+
+ModInt& ModInt::operator-=(const ModInt& b){
+	if(mont < b.mont){
+		mont += ctx->getModulus();
+	}
+	mont -= b.mont;
+	return *this;
+}
+
+ModInt& ModInt::operator*=(const ModInt& b){
+	int nl = ctx->limbs();
+	LimbArena& arena = scratchArena();
+	ArenaScope scope(arena);
+	limb_t* x = arena.take(nl);
+	limb_t* t = arena.take(2*nl);
+	load(x, mont);
+	if(&b == this){
+		ctx->sqr(x, x, t);
+	}
+	else{
+		limb_t* y = arena.take(nl);
+		load(y, b.mont);
+		ctx->mul(x, x, y, t);
+	}
+	mont.setLimbs(x, nl);
+	return *this;
+}
+
+bool ModInt::operator==(const ModInt& b) const{
+	return mont == b.mont;
+}
+
+bool ModInt::operator!=(const ModInt& b) const{
+	return !(mont == b.mont);
+}
+
+// The result stays in Montgomery form; the constructor brings it below n, which + and
+// - rely on.
+ModInt ModInt::pow(const BigNum& e) const{
+	int nl = ctx->limbs();
+	LimbArena& arena = scratchArena();
+	ArenaScope scope(arena);
+	limb_t* x = arena.take(nl);
+	load(x, mont);
+	ctx->powMont(x, x, e);
+	return ModInt(ctx, x, nl);
+}
+
+ModInt ModInt::inverse() const{
+	return ModInt(ctx, modInverse(value(), ctx->getModulus()));
+}
+
+BigNum ModInt::mulPlain(const BigNum& a) const{
+	const BigNum& n = ctx->getModulus();
+	int nl = ctx->limbs();
+	LimbArena& arena = scratchArena();
+	ArenaScope scope(arena);
+	limb_t* x = arena.take(nl);
+	limb_t* y = arena.take(nl);
+	limb_t* t = arena.take(2*nl);
+	load(x, mont);
+	//REDC reduces fully only for a product below nR.
+	if(a >= n){
+		load(y, a % n);
+	}
+	else{
+		load(y, a);
+	}
+	ctx->mul(x, x, y, t);
+	BigNum response;
+	response.setLimbs(x, nl);
+	return response;
+}
+
+}
@@ -0,0 +1,114 @@
+#ifndef MODINT_H_
+#define MODINT_H_
+#include <memory>
+#include "Montgomery.h"
+
+namespace RSAUtil
+{
+
+/****************************************************************************************
+ * A residue mod n that stays in Montgomery form between operations.  Chaining plain
+ * BigNum operations under one modulus pays a long division for every "% n"; a ModInt
+ * is converted in once, multiplied with one Montgomery product per "*", added and
+ * subtracted with at most one subtraction of n, and converted back out only when
+ * value() is called.
+ *
+ * Every ModInt holds the MontContext of its modulus, which is shared and immutable,
+ * so ModInts under the same modulus can be used from any number of threads.  The
+ * operands of a binary operator must share a modulus.  n must be odd and greater
+ * than 1, as for MontContext.
+ *
+ * @class: ModInt
+ * @namespace: RSAUtil
+ * @file: ModInt.h
+ * @version: 1.0.0.0
+ * @date: 10/18/2026
+ * **************************************************************************************
+ */
+class ModInt
+{
+private:
+	std::shared_ptr<const MontContext> ctx;
+	//xR mod n, fully reduced, for the value x.
+	BigNum mont;
+
+	/*
+	 * *******************************************************************************
+	 * Constructor from limbs() limbs already in Montgomery form, as powMont() leaves
+	 * them: below R but not necessarily below n, so they are reduced mod n first.
+	 * *******************************************************************************
+	 */
+	ModInt(const std::shared_ptr<const MontContext>&, const limb_t*, int);
+
+	void load(limb_t*, const BigNum&) const;
+
+public:
+	/*
+	 * *******************************************************************************
+	 * Constructors.
+	 * ModInt(): Bound to no modulus; only good for assigning to.
+	 * ModInt(context, BigNum): The given value, reduced mod the context's modulus.
+	 * *******************************************************************************
+	 */
+	ModInt();
+	ModInt(const std::shared_ptr<const MontContext>&, const BigNum&);
+	virtual ~ModInt();
+
+	const std::shared_ptr<const MontContext>& getContext() const;
+
+	/*
+	 * *******************************************************************************
+	 * value.	The residue as a plain number below n.
+	 * *******************************************************************************
+	 */
+	BigNum value() const;
+
+	bool isZero() const;
+
+	/*
+	 * *******************************************************************************
+	 * Arithmetic operators, all mod n.
+	 * *******************************************************************************
+	 */
+	ModInt operator+(const ModInt&) const;
+	ModInt operator-(const ModInt&) const;
+	ModInt operator*(const ModInt&) const;
+	ModInt& operator+=(const ModInt&);
+	ModInt& operator-=(const ModInt&);
+	ModInt& operator*=(const ModInt&);
+
+	bool operator==(const ModInt&) const;
+	bool operator!=(const ModInt&) const;
+
+	/*
+	 * *******************************************************************************
+	 * pow.	Sliding window exponentiation, see MontContext::powMont().
+	 * @parameter BigNum:	The exponent.
+	 * @returns ModInt:	This residue to the given power.
+	 * *******************************************************************************
+	 */
+	ModInt pow(const BigNum&) const;
+
+	/*
+	 * *******************************************************************************
+	 * inverse.	The multiplicative inverse mod n.
+	 * @returns ModInt:	The inverse, or 0 if there is none.
+	 * *******************************************************************************
+	 */
+	ModInt inverse() const;
+
+	/*
+	 * *******************************************************************************
+	 * mulPlain.	[x * a] mod n for a plain number a, returned as a plain number.
+	 * 				One Montgomery product does it, since xR * a R^-1 = xa: a value
+	 * 				used many times against plain inputs is best kept as a ModInt.
+	 * @parameter BigNum:	a.
+	 * @returns BigNum:	[x * a] mod n.
+	 * *******************************************************************************
+	 */
+	BigNum mulPlain(const BigNum&) const;
+};
+
+}
+
+#endif /*MODINT_H_*/
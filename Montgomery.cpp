@@ -0,0 +1,303 @@
+#include "Montgomery.h"
+#include <cstring>
+
+namespace RSAUtil
+{
+
+MontContext::MontContext(const BigNum& modulus) : n(modulus)
+{
+	nl = n.size();
+
+	//Newton iteration for n^-1 mod 2^64; each step doubles the correct bits.
+	limb_t n0 = n.limb(0);
+	limb_t x = n0;
+	for(int i=0; i<6; i++){
+		x *= 2 - n0*x;
+	}
+	n0inv = (limb_t)0 - x;
+
+	BigNum r2(1);
+	r2 <<= 2*nl*LIMB_BITS;
+	rr = r2 % n;
+}
+
+MontContext::~MontContext()
+{
+}
+
+const BigNum& MontContext::getModulus() const{
+	return n;
+}
+
+int MontContext::limbs() const{
+	return nl;
+}
+
+//REDC.  The result is t/R + (something below n), so below n + t/R.  A full
+//reduction compares it against n; a lazy one only subtracts n when it overflows
+//R, which keeps every residue below R as long as t < R^2.
+void MontContext::redc(limb_t* r, limb_t* t, bool lazy) const{
+	const limb_t* m = n.limbs();
+	limb_t extra = 0;
+
+	//Clear one low limb per row; the carries out of each row collect in extra.
+	for(int i=0; i<nl; i++){
+		limb_t u = t[i]*n0inv;
+		limb_t c = limbAddMul1(t + i, m, nl, u);
+		limb_t s = t[i+nl] + c;
+		limb_t c1 = (s < c);
+		s += extra;
+		c1 += (s < extra);
+		t[i+nl] = s;
+		extra = c1;
+	}
+	if(extra || (!lazy && limbCmp(t + nl, m, nl) >= 0)){
+		limbSub(r, t + nl, m, nl);
+	}
+	else{
+		std::memcpy(r, t + nl, nl*sizeof(limb_t));
+	}
+}
+
+void MontContext::reduce(limb_t* r, limb_t* t) const{
+	redc(r, t, false);
+}
+
+void MontContext::mul(limb_t* r, const limb_t* a, const limb_t* b, limb_t* t) const{
+	limbMul(t, a, nl, b, nl);
+	redc(r, t, false);
+}
+
+void MontContext::sqr(limb_t* r, const limb_t* a, limb_t* t) const{
+	limbSqr(t, a, nl);
+	redc(r, t, false);
+}
+
+void MontContext::mulLazy(limb_t* r, const limb_t* a, const limb_t* b, limb_t* t) const{
+	limbMul(t, a, nl, b, nl);
+	redc(r, t, true);
+}
+
+void MontContext::sqrLazy(limb_t* r, const limb_t* a, limb_t* t) const{
+	limbSqr(t, a, nl);
+	redc(r, t, true);
+}
+
+void MontContext::toMont(limb_t* r, const BigNum& a) const{
+	LimbArena& arena = scratchArena();
+	ArenaScope scope(arena);
+	limb_t* x = arena.take(nl);
+	limb_t* t = arena.take(2*nl);
+
+	//Values already below n, such as those fromMont() returns, need no division.
+	std::memset(x, 0, nl*sizeof(limb_t));
+	if(a.size() > nl || (a.size() == nl && limbCmp(a.limbs(), n.limbs(), nl) >= 0)){
+		limbDivRem(0, x, a.limbs(), a.size(), n.limbs(), nl);
+	}
+	else{
+		std::memcpy(x, a.limbs(), a.size()*sizeof(limb_t));
+	}
+	//xR = REDC(x * R^2).
+	std::memset(t, 0, 2*nl*sizeof(limb_t));
+	limbMul(t, x, nl, rr.limbs(), rr.size());
+	reduce(r, t);
+}
+
+BigNum MontContext::fromMont(const limb_t* a) const{
+	BigNum response;
+	response.reserve(nl);
+	LimbArena& arena = scratchArena();
+	ArenaScope scope(arena);
+	limb_t* t = arena.take(2*nl);
+
+	std::memcpy(t, a, nl*sizeof(limb_t));
+	std::memset(t + nl, 0, nl*sizeof(limb_t));
+	reduce(t, t);
+	response.setLimbs(t, nl);
+	return response;
+}
+
+//a^b mod n using sliding window exponentiation on Montgomery residues.  The
+//residues are only kept below R; fromMont() brings the result below n.
+BigNum MontContext::pow(const BigNum& a, const BigNum& b) const{
+	if(b.isZero()){
+		return BigNum(1);
+	}
+	if(nl == 1){
+		return modPow(a, b, n);
+	}
+	LimbArena& arena = scratchArena();
+	ArenaScope scope(arena);
+	limb_t* acc = arena.take(nl);
+
+	toMont(acc, a);
+	powMont(acc, acc, b);
+	return fromMont(acc);
+}
+
+void MontContext::powMont(limb_t* r, const limb_t* a, const BigNum& b) const{
+	if(b.isZero()){
+		toMont(r, BigNum(1));
+		return;
+	}
+	LimbArena& arena = scratchArena();
+	ArenaScope scope(arena);
+	int k = expWindowBits(b.bitLength());
+	int tableSize = 1 << (k-1);
+	limb_t* table = arena.take(tableSize*nl);
+	limb_t* acc = arena.take(nl);
+	limb_t* base2 = arena.take(nl);
+	limb_t* t = arena.take(2*nl);
+
+	//table[i] = a^(2i+1).
+	std::memcpy(table, a, nl*sizeof(limb_t));
+	if(tableSize > 1){
+		sqrLazy(base2, table, t);
+		for(int i=1; i<tableSize; i++){
+			mulLazy(table + i*nl, table + (i-1)*nl, base2, t);
+		}
+	}
+
+	bool started = false;
+	int i = b.bitLength() - 1;
+	while(i >= 0){
+		if(!b[i]){
+			if(started){
+				sqrLazy(acc, acc, t);
+			}
+			i--;
+			continue;
+		}
+		//Take the longest window ending in a set bit.
+		int j = (i - k + 1 > 0) ? (i - k + 1) : 0;
+		while(!b[j]){
+			j++;
+		}
+		int val = 0;
+		for(int bit=i; bit>=j; bit--){
+			val = (val << 1) | b[bit];
+		}
+		if(started){
+			for(int bit=i; bit>=j; bit--){
+				sqrLazy(acc, acc, t);
+			}
+			mulLazy(acc, acc, table + ((val-1)/2)*nl, t);
+		}
+		else{
+			std::memcpy(acc, table + ((val-1)/2)*nl, nl*sizeof(limb_t));
+			started = true;
+		}
+		i = j - 1;
+	}
+	std::memcpy(r, acc, nl*sizeof(limb_t));
+}
+
+//The next sliding window of an exponent at or below bit from: the bits from the
+//highest set one down to low, at most k of them and ending in a set bit.  low is
+//-1 once the exponent has none left.
+struct ExpWindow
+{
+	int low;
+	int val;
+};
+
+static void nextWindow(const BigNum& e, int from, int k, ExpWindow& w){
+	while(from >= 0 && !e[from]){
+		from--;
+	}
+	if(from < 0){
+		w.low = -1;
+		return;
+	}
+	int j = (from - k + 1 > 0) ? (from - k + 1) : 0;
+	while(!e[j]){
+		j++;
+	}
+	w.low = j;
+	w.val = 0;
+	for(int bit=from; bit>=j; bit--){
+		w.val = (w.val << 1) | e[bit];
+	}
+}
+
+BigNum MontContext::multiPow(const std::vector<std::pair<BigNum, BigNum> >& terms) const{
+	if(nl == 1){
+		return multiModPow(terms, n);
+	}
+	LimbArena& arena = scratchArena();
+	ArenaScope scope(arena);
+	size_t count = terms.size();
+	std::vector<limb_t*> tables(count);
+	std::vector<int> widths(count);
+	std::vector<ExpWindow> windows(count);
+	limb_t* acc = arena.take(nl);
+	limb_t* base2 = arena.take(nl);
+	limb_t* t = arena.take(2*nl);
+
+	//Per term, as in pow(): table[i] = a^(2i+1), in Montgomery form.
+	int top = -1;
+	for(size_t c=0; c<count; c++){
+		const BigNum& e = terms[c].second;
+		int bits = e.bitLength();
+		widths[c] = expWindowBits(bits);
+		int tableSize = 1 << (widths[c]-1);
+		tables[c] = arena.take(tableSize*nl);
+		toMont(tables[c], terms[c].first);
+		if(tableSize > 1){
+			sqrLazy(base2, tables[c], t);
+			for(int i=1; i<tableSize; i++){
+				mulLazy(tables[c] + i*nl, tables[c] + (i-1)*nl, base2, t);
+			}
+		}
+		nextWindow(e, bits - 1, widths[c], windows[c]);
+		if(bits - 1 > top){
+			top = bits - 1;
+		}
+	}
+
+	bool started = false;
+	for(int bit=top; bit>=0; bit--){
+		if(started){
+			sqrLazy(acc, acc, t);
+		}
+		for(size_t c=0; c<count; c++){
+			if(windows[c].low != bit){
+				continue;
+			}
+			const limb_t* entry = tables[c] + ((windows[c].val-1)/2)*nl;
+			if(started){
+				mulLazy(acc, acc, entry, t);
+			}
+			else{
+				std::memcpy(acc, entry, nl*sizeof(limb_t));
+				started = true;
+			}
+			nextWindow(terms[c].second, bit - 1, widths[c], windows[c]);
+		}
+	}
+	if(!started){
+		return BigNum(1);
+	}
+	return fromMont(acc);
+}
+
+BigNum MontContext::powFermat(const BigNum& a, int k) const{
+	if(nl == 1){
+		return modPow(a, (BigNum(1) << k) + 1, n);
+	}
+	LimbArena& arena = scratchArena();
+	ArenaScope scope(arena);
+	limb_t* base = arena.take(nl);
+	limb_t* acc = arena.take(nl);
+	limb_t* t = arena.take(2*nl);
+
+	toMont(base, a);
+	sqrLazy(acc, base, t);
+	for(int i=1; i<k; i++){
+		sqrLazy(acc, acc, t);
+	}
+	mulLazy(acc, acc, base, t);
+	return fromMont(acc);
+}
+
+}
@@ -0,0 +1,154 @@
+#ifndef MONTGOMERY_H_
+#define MONTGOMERY_H_
+#include "BigNum.h"
+
+namespace RSAUtil
+{
+
+	/*
+	 * **********************************************************************************
+	 * Precomputed values for Montgomery multiplication modulo an odd number n.  With
+	 * R = 2^(64*limbs()), a residue x is held as xR mod n; multiplying two such
+	 * residues and reducing by R (REDC) costs about as much as the product itself,
+	 * where a plain "% n" costs a full long division.
+	 *
+	 * A MontContext is immutable once built, so one context can be shared by any
+	 * number of threads.  Scratch space comes from the caller or from the calling
+	 * thread's arena.
+	 *
+	 * @class: MontContext
+	 * @namespace: RSAUtil
+	 * @file: Montgomery.h
+	 * @version: 1.0.0.0
+	 * @date: 10/18/2026
+	 * **********************************************************************************
+	 */
+class MontContext
+{
+private:
+	//The modulus.
+	BigNum n;
+	//R^2 mod n, used to move values into Montgomery form.
+	BigNum rr;
+	//-n^-1 mod 2^64.
+	limb_t n0inv;
+	//Number of limbs in n.
+	int nl;
+
+	void redc(limb_t*, limb_t*, bool) const;
+
+public:
+	/*
+	 * *******************************************************************************
+	 * Constructor.  Computes the context for the given modulus, which must be odd
+	 * and greater than 1.
+	 * *******************************************************************************
+	 */
+	MontContext(const BigNum&);
+	virtual ~MontContext();
+
+	const BigNum& getModulus() const;
+
+	/*
+	 * *******************************************************************************
+	 * limbs.	Number of limbs in the modulus, and so in every residue.
+	 * *******************************************************************************
+	 */
+	int limbs() const;
+
+	/*
+	 * *******************************************************************************
+	 * mul.	Montgomery product r = abR^-1 mod n of two limbs()-limb residues.
+	 * @parameter limb_t*:	The result, limbs() limbs.  May be a or b.
+	 * @parameter const limb_t*:	The first residue.
+	 * @parameter const limb_t*:	The second residue.
+	 * @parameter limb_t*:	Scratch space of 2*limbs() limbs.
+	 * *******************************************************************************
+	 */
+	void mul(limb_t*, const limb_t*, const limb_t*, limb_t*) const;
+
+	/*
+	 * *******************************************************************************
+	 * sqr.	Montgomery square r = aaR^-1 mod n, using limbSqr.  Same parameters as
+	 * 		mul() with a single residue.
+	 * *******************************************************************************
+	 */
+	void sqr(limb_t*, const limb_t*, limb_t*) const;
+
+	/*
+	 * *******************************************************************************
+	 * mulLazy / sqrLazy.	mul() and sqr() without the final comparison against n.
+	 * 			The inputs may be any values below R, and so may the result, which is
+	 * 			congruent to the fully reduced one.  A chain of these needs one full
+	 * 			reduction at the end, which fromMont() does.
+	 * *******************************************************************************
+	 */
+	void mulLazy(limb_t*, const limb_t*, const limb_t*, limb_t*) const;
+	void sqrLazy(limb_t*, const limb_t*, limb_t*) const;
+
+	/*
+	 * *******************************************************************************
+	 * reduce.	Montgomery reduction r = tR^-1 mod n of a 2*limbs()-limb value t < nR.
+	 * 			t is overwritten.
+	 * *******************************************************************************
+	 */
+	void reduce(limb_t*, limb_t*) const;
+
+	/*
+	 * *******************************************************************************
+	 * toMont / fromMont.	Convert a number into Montgomery form (reducing it mod n
+	 * 						first) and a residue back out of it.  fromMont() takes
+	 * 						any residue below R and returns a value below n.
+	 * *******************************************************************************
+	 */
+	void toMont(limb_t*, const BigNum&) const;
+	BigNum fromMont(const limb_t*) const;
+
+	/*
+	 * *******************************************************************************
+	 * pow.	Sliding window exponentiation [a^b] mod n.
+	 * @parameter BigNum:	The base.
+	 * @parameter BigNum:	The exponent.
+	 * @returns BigNum:		[a^b] mod n.
+	 * *******************************************************************************
+	 */
+	BigNum pow(const BigNum&, const BigNum&) const;
+
+	/*
+	 * *******************************************************************************
+	 * powMont.	The same exponentiation on residues, without leaving Montgomery
+	 * 			form.  The base may be any residue below R, and so may the result.
+	 * @parameter limb_t*:	The result, limbs() limbs.  May be the base.
+	 * @parameter const limb_t*:	The base residue.
+	 * @parameter BigNum:	The exponent.
+	 * *******************************************************************************
+	 */
+	void powMont(limb_t*, const limb_t*, const BigNum&) const;
+
+	/*
+	 * *******************************************************************************
+	 * multiPow.	[a1^b1 * a2^b2 * ...] mod n by interleaved sliding windows (Straus):
+	 * 				each term gets the table pow() would build for it, and one pass
+	 * 				from the top exponent bit squares once per bit and multiplies in
+	 * 				each term's entry where its window ends.  See multiModPow().
+	 * @parameter std::vector<std::pair<BigNum, BigNum> >:	The (base, exponent) terms.
+	 * @returns BigNum:		The product mod n.
+	 * *******************************************************************************
+	 */
+	BigNum multiPow(const std::vector<std::pair<BigNum, BigNum> >&) const;
+
+	/*
+	 * *******************************************************************************
+	 * powFermat.	[a^(2^k + 1)] mod n by k squarings and one multiplication, for
+	 * 				exponents such as 3 and 65537.
+	 * @parameter BigNum:	The base.
+	 * @parameter int:	k (>= 1).
+	 * @returns BigNum:		[a^(2^k + 1)] mod n.
+	 * *******************************************************************************
+	 */
+	BigNum powFermat(const BigNum&, int) const;
+};
+
+}
+
+#endif /*MONTGOMERY_H_*/
@@ -0,0 +1,207 @@
+#include "PrimeBitmap.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace RSAUtil
+{
+
+//The file starts with PRIME_BITMAP_MAGIC and the number of wheel bytes.
+#define PRIME_BITMAP_MAGIC "RSAPRM30"
+#define PRIME_BITMAP_HEADER 16
+//One byte per 30 numbers up to 2^32.
+#define PRIME_BITMAP_BYTES ((((unsigned long long)1 << 32) + 29) / 30)
+//Wheel bytes sieved at a time by build().
+#define PRIME_BITMAP_SEGMENT 16384
+
+//The numbers below 30 that are prime to 30, one per bit of a wheel byte.
+static const unsigned int wheelResidue[8] = {1, 7, 11, 13, 17, 19, 23, 29};
+
+//The bit of each residue mod 30, or -1 for the multiples of 2, 3 and 5.
+static const signed char wheelBit[30] = {
+	-1, 0, -1, -1, -1, -1, -1, 1, -1, -1, -1, 2, -1, 3, -1,
+	-1, -1, 4, -1, 5, -1, -1, -1, 6, -1, -1, -1, -1, -1, 7
+};
+
+PrimeBitmap::PrimeBitmap(const std::string& file)
+	: map(0), mapLength(0), wheel(0)
+{
+	int fd = open(file.c_str(), O_RDONLY);
+	if(fd < 0){
+		return;
+	}
+	struct stat st;
+	if(fstat(fd, &st) == 0 && (unsigned long long)st.st_size == PRIME_BITMAP_HEADER + PRIME_BITMAP_BYTES){
+		void* p = mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		if(p != MAP_FAILED){
+			map = (const unsigned char*)p;
+			mapLength = st.st_size;
+		}
+	}
+	close(fd);
+	if(map && std::memcmp(map, PRIME_BITMAP_MAGIC, 8) == 0){
+		wheel = map + PRIME_BITMAP_HEADER;
+	}
+}
+
+PrimeBitmap::~PrimeBitmap()
+{
+	if(map){
+		munmap((void*)map, mapLength);
+	}
+}
+
+bool PrimeBitmap::isOpen() const{
+	return wheel != 0;
+}
+
+bool PrimeBitmap::isPrime(unsigned int n) const{
+	if(n < 7){
+		return n == 2 || n == 3 || n == 5;
+	}
+	int bit = wheelBit[n % 30];
+	return bit >= 0 && ((wheel[n / 30] >> bit) & 1);
+}
+
+unsigned int PrimeBitmap::nextPrime(unsigned int n) const{
+	if(n <= 5){
+		return (n <= 2) ? 2 : ((n == 3) ? 3 : 5);
+	}
+	unsigned long long byte = n / 30;
+	//Drop the bits of the first byte below n.
+	unsigned int bits = wheel[byte];
+	for(int j=0; j<8 && wheelResidue[j] < n % 30; j++){
+		bits &= ~(1u << j);
+	}
+	while(bits == 0){
+		if(++byte >= PRIME_BITMAP_BYTES){
+			return 0;
+		}
+		bits = wheel[byte];
+	}
+	return (unsigned int)(byte*30 + wheelResidue[__builtin_ctz(bits)]);
+}
+
+unsigned int PrimeBitmap::randomPrime(unsigned int lo, unsigned int hi, unsigned int fixedE) const{
+	if(lo > hi){
+		return 0;
+	}
+	static thread_local std::random_device device;
+	std::uniform_int_distribution<unsigned int> pick(lo, hi);
+	unsigned int start = pick(device);
+	unsigned long long from = start;
+	bool wrapped = false;
+	for(;;){
+		unsigned int p = (from >> 32) ? 0 : nextPrime((unsigned int)from);
+		if(p == 0 || p > hi){
+			if(wrapped){
+				return 0;
+			}
+			wrapped = true;
+			from = lo;
+			continue;
+		}
+		if(wrapped && p >= start){
+			return 0;
+		}
+		//gcd(e, p-1) == 1 for a prime e means p != 1 mod e.
+		if(fixedE == 0 || p % fixedE != 1){
+			return p;
+		}
+		from = (unsigned long long)p + 1;
+	}
+}
+
+bool PrimeBitmap::build(const std::string& file){
+	const unsigned long long limit = (unsigned long long)1 << 32;
+	const unsigned long long span = 30ULL*PRIME_BITMAP_SEGMENT;
+
+	//The sieving primes: 7 up to 2^16, the square root of the range.
+	std::vector<unsigned int> sieving;
+	std::vector<char> composite(1 << 16, 0);
+	for(unsigned int i=2; i<(1u << 16); i++){
+		if(composite[i]){
+			continue;
+		}
+		if(i >= 7){
+			sieving.push_back(i);
+		}
+		for(unsigned int j=i*i; j<(1u << 16); j+=i){
+			composite[j] = 1;
+		}
+	}
+
+	std::string tmp = file + ".tmp";
+	std::ofstream out(tmp.c_str(), std::ios::binary);
+	unsigned long long bytes = PRIME_BITMAP_BYTES;
+	out.write(PRIME_BITMAP_MAGIC, 8);
+	out.write((const char*)&bytes, sizeof(bytes));
+
+	//odd[i] is set while lo + 2i + 1 may be prime.
+	std::vector<unsigned char> odd(span / 2);
+	std::vector<unsigned char> segment(PRIME_BITMAP_SEGMENT);
+	for(unsigned long long lo=0; lo<limit && out; lo+=span){
+		std::memset(&odd[0], 1, odd.size());
+		for(size_t i=0; i<sieving.size(); i++){
+			unsigned long long p = sieving[i];
+			unsigned long long m = p*p;
+			if(m >= lo + span){
+				break;
+			}
+			if(m < lo){
+				m = (lo + p - 1) / p * p;
+				if(!(m & 1)){
+					m += p;
+				}
+			}
+			for(; m<lo+span; m+=2*p){
+				odd[(m - lo) / 2] = 0;
+			}
+		}
+		size_t count = PRIME_BITMAP_SEGMENT;
+		if(lo/30 + count > bytes){
+			count = bytes - lo/30;
+		}
+		for(size_t b=0; b<count; b++){
+			unsigned char bits = 0;
+			for(int j=0; j<8; j++){
+				unsigned long long n = lo + 30*b + wheelResidue[j];
+				if(n > 1 && n < limit && odd[(n - lo) / 2]){
+					bits |= 1 << j;
+				}
+			}
+			segment[b] = bits;
+		}
+		out.write((const char*)&segment[0], count);
+	}
+	out.close();
+	if(!out){
+		std::remove(tmp.c_str());
+		return false;
+	}
+	return std::rename(tmp.c_str(), file.c_str()) == 0;
+}
+
+static const PrimeBitmap* openShared(){
+	const char* file = std::getenv(PRIME_BITMAP_ENV);
+	PrimeBitmap* bitmap = new PrimeBitmap((file && *file) ? file : PRIME_BITMAP_FILE);
+	if(!bitmap->isOpen()){
+		delete bitmap;
+		return 0;
+	}
+	return bitmap;
+}
+
+const PrimeBitmap* PrimeBitmap::shared(){
+	static const PrimeBitmap* bitmap = openShared();
+	return bitmap;
+}
+
+}
@@ -0,0 +1,116 @@
+#ifndef PRIMEBITMAP_H_
+#define PRIMEBITMAP_H_
+#include <string>
+
+namespace RSAUtil
+{
+
+//Environment variable naming the bitmap file PrimeBitmap::shared() maps; without it
+//PRIME_BITMAP_FILE in the working directory is used.
+#define PRIME_BITMAP_ENV "RSAUTIL_PRIME_BITMAP"
+#define PRIME_BITMAP_FILE "rsautil-primes.bitmap"
+
+/****************************************************************************************
+ * A bitmap of the primes below 2^32, kept in a file and memory-mapped, so that
+ * primality of any 32 bit number is a single bit lookup and the next prime after any
+ * number is a short scan.
+ *
+ * The bitmap uses a mod 30 wheel: byte i holds one bit for each of the eight numbers
+ * 30i + {1, 7, 11, 13, 17, 19, 23, 29}, the only ones not divisible by 2, 3 or 5, so
+ * the whole 32 bit range takes 137MB.  2, 3 and 5 are answered without it.  The
+ * file is written once by build() (see mkprimes.cpp) and only read after that; the
+ * pages are loaded by the kernel as queries touch them.
+ *
+ * isPrime(int), isPrime(BigNum) and randomPrime() (see RSA.h) use shared() for
+ * numbers that fit in 32 bits and fall back to testing when there is no bitmap.
+ *
+ * @class: PrimeBitmap
+ * @namespace: RSAUtil
+ * @file: PrimeBitmap.h
+ * @version: 1.0.0.0
+ * @date: 10/18/2026
+ * **************************************************************************************
+ */
+class PrimeBitmap
+{
+private:
+	//The mapping: a header, then the wheel bytes.
+	const unsigned char* map;
+	size_t mapLength;
+	const unsigned char* wheel;
+
+	PrimeBitmap(const PrimeBitmap&);
+	PrimeBitmap& operator=(const PrimeBitmap&);
+
+public:
+	/*
+	 * *******************************************************************************
+	 * Constructor.  Maps the given bitmap file; isOpen() tells whether that worked.
+	 * *******************************************************************************
+	 */
+	PrimeBitmap(const std::string&);
+
+	/*
+	 * *******************************************************************************
+	 * Destructor.  Unmaps the file.
+	 * *******************************************************************************
+	 */
+	virtual ~PrimeBitmap();
+
+	/*
+	 * *******************************************************************************
+	 * isOpen.	False if the file was missing, unreadable or not a prime bitmap.
+	 * *******************************************************************************
+	 */
+	bool isOpen() const;
+
+	/*
+	 * *******************************************************************************
+	 * isPrime.	Primality of a 32 bit number, by lookup.
+	 * *******************************************************************************
+	 */
+	bool isPrime(unsigned int) const;
+
+	/*
+	 * *******************************************************************************
+	 * nextPrime.	The smallest prime at or above the given number.
+	 * @returns unsigned int:	The prime, or 0 if there is none below 2^32.
+	 * *******************************************************************************
+	 */
+	unsigned int nextPrime(unsigned int) const;
+
+	/*
+	 * *******************************************************************************
+	 * randomPrime.	A prime in [lo, hi]: the first one at or after a uniformly random
+	 * 				point, wrapping around to lo.  As with any search from a random
+	 * 				start, primes after long gaps are a little more likely.
+	 * @parameter unsigned int:	lo.
+	 * @parameter unsigned int:	hi.
+	 * @parameter unsigned int:	A prime e with gcd(e, p-1) == 1 required, or 0.
+	 * @returns unsigned int:	The prime, or 0 if the range has none.
+	 * *******************************************************************************
+	 */
+	unsigned int randomPrime(unsigned int, unsigned int, unsigned int) const;
+
+	/*
+	 * *******************************************************************************
+	 * build.	Sieves the primes below 2^32 and writes the bitmap file, through a
+	 * 			temporary file renamed over it.  Takes some seconds.
+	 * @returns bool:	False if the file could not be written.
+	 * *******************************************************************************
+	 */
+	static bool build(const std::string&);
+
+	/*
+	 * *******************************************************************************
+	 * shared.	The process-wide bitmap, mapped on first use from the file named by
+	 * 			PRIME_BITMAP_ENV, or PRIME_BITMAP_FILE.
+	 * @returns const PrimeBitmap*:	The bitmap, or null if there is no such file.
+	 * *******************************************************************************
+	 */
+	static const PrimeBitmap* shared();
+};
+
+}
+
+#endif /*PRIMEBITMAP_H_*/
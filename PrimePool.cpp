@@ -0,0 +1,175 @@
+#include "PrimePool.h"
+#include "RSA.h"
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace RSAUtil
+{
+
+bool PrimePool::PrimeClass::operator<(const PrimeClass& o) const{
+	if(bits != o.bits){
+		return bits < o.bits;
+	}
+	if(topBits != o.topBits){
+		return topBits < o.topBits;
+	}
+	return fixedE < o.fixedE;
+}
+
+PrimePool::PrimePool(size_t poolDepth, int threads, const std::string& file)
+	: depth(poolDepth), cacheFile(file), stopping(false)
+{
+	if(!cacheFile.empty()){
+		load();
+	}
+	for(int i=0; i<threads; i++){
+		producers.push_back(std::thread(&PrimePool::produce, this));
+	}
+}
+
+PrimePool::~PrimePool()
+{
+	{
+		std::lock_guard<std::mutex> guard(stockLock);
+		stopping = true;
+	}
+	stockLow.notify_all();
+	for(size_t i=0; i<producers.size(); i++){
+		producers[i].join();
+	}
+	if(!cacheFile.empty()){
+		save();
+	}
+}
+
+// Reads the cache file, keeping the entries that are still prime and match their
+// class, then deletes it so that none of them can be handed out again.
+void PrimePool::load(){
+	std::ifstream in(cacheFile.c_str());
+	PrimeClass c;
+	std::string digits;
+	while(in >> c.bits >> c.topBits >> c.fixedE >> digits){
+		BigNum p = BigNum::fromHex(digits);
+		bool ok = (p.bitLength() == c.bits) && c.topBits >= 1 && c.topBits <= c.bits;
+		for(int i=1; ok && i<=c.topBits; i++){
+			ok = (p[c.bits - i] == 1);
+		}
+		if(ok && c.fixedE > 1){
+			ok = (BigNum::divModWord(0, p - 1, c.fixedE) != 0);
+		}
+		if(ok && isPrime(p)){
+			stock[c].push_back(p);
+		}
+	}
+	in.close();
+	std::remove(cacheFile.c_str());
+}
+
+// Writes the unused primes to the cache file, replacing it.  Only the destructor
+// calls this, once the producers are stopped.  The primes go out as raw hex limbs:
+// toHexString() and toDecString() work in the thread's scratch arena, which is
+// already gone when a static pool is destroyed at exit.
+bool PrimePool::save(){
+	std::string text;
+	{
+		std::lock_guard<std::mutex> guard(stockLock);
+		for(std::map<PrimeClass, std::deque<BigNum> >::const_iterator it=stock.begin();
+				it!=stock.end(); ++it){
+			for(size_t i=0; i<it->second.size(); i++){
+				const BigNum& p = it->second[i];
+				char buffer[64];
+				std::snprintf(buffer, sizeof(buffer), "%d %d %u ",
+					it->first.bits, it->first.topBits, it->first.fixedE);
+				text += buffer;
+				for(int k=p.size()-1; k>=0; k--){
+					std::snprintf(buffer, sizeof(buffer), "%016llx", p.limbs()[k]);
+					text += buffer;
+				}
+				text += "\n";
+			}
+		}
+	}
+
+	//Write to a private temporary file and rename it over the cache.  fchmod()
+	//covers a temporary file left behind with other permissions.
+	std::string tmp = cacheFile + ".tmp";
+	int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	if(fd < 0){
+		return false;
+	}
+	bool ok = (fchmod(fd, 0600) == 0);
+	for(size_t done=0; ok && done<text.size(); ){
+		ssize_t n = write(fd, text.data() + done, text.size() - done);
+		ok = (n > 0);
+		done += ok ? n : 0;
+	}
+	ok = (close(fd) == 0) && ok;
+	if(!ok){
+		std::remove(tmp.c_str());
+		return false;
+	}
+	return std::rename(tmp.c_str(), cacheFile.c_str()) == 0;
+}
+
+void PrimePool::reserve(int bits, int topBits, unsigned int fixedE){
+	PrimeClass c = {bits, topBits, fixedE};
+	{
+		std::lock_guard<std::mutex> guard(stockLock);
+		stock[c];
+	}
+	stockLow.notify_one();
+}
+
+BigNum PrimePool::take(int bits, int topBits, unsigned int fixedE){
+	PrimeClass c = {bits, topBits, fixedE};
+	{
+		std::lock_guard<std::mutex> guard(stockLock);
+		std::deque<BigNum>& ready = stock[c];
+		if(!ready.empty()){
+			BigNum p = ready.front();
+			ready.pop_front();
+			stockLow.notify_one();
+			return p;
+		}
+	}
+	stockLow.notify_one();
+	return randomPrime(bits, topBits, fixedE);
+}
+
+size_t PrimePool::available(int bits, int topBits, unsigned int fixedE){
+	PrimeClass c = {bits, topBits, fixedE};
+	std::lock_guard<std::mutex> guard(stockLock);
+	std::map<PrimeClass, std::deque<BigNum> >::const_iterator it = stock.find(c);
+	return (it == stock.end()) ? 0 : it->second.size();
+}
+
+// Body of a producer thread: fills the emptiest class below depth, searching for
+// each prime outside the lock, and sleeps while every class is full.
+void PrimePool::produce(){
+	std::unique_lock<std::mutex> guard(stockLock);
+	while(!stopping){
+		const PrimeClass* lowest = 0;
+		size_t lowestSize = depth;
+		for(std::map<PrimeClass, std::deque<BigNum> >::const_iterator it=stock.begin();
+				it!=stock.end(); ++it){
+			if(it->second.size() < lowestSize){
+				lowest = &it->first;
+				lowestSize = it->second.size();
+			}
+		}
+		if(!lowest){
+			stockLow.wait(guard);
+			continue;
+		}
+		PrimeClass c = *lowest;
+		guard.unlock();
+		BigNum p = randomPrime(c.bits, c.topBits, c.fixedE);
+		guard.lock();
+		stock[c].push_back(p);
+	}
+}
+
+}
@@ -0,0 +1,120 @@
+#ifndef PRIMEPOOL_H_
+#define PRIMEPOOL_H_
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "BigNum.h"
+
+namespace RSAUtil
+{
+
+/****************************************************************************************
+ * A pool of ready-made primes, kept filled by background threads so that key
+ * generation can take its primes in O(1) instead of searching for them inline.
+ *
+ * Primes come in classes, each described by the arguments of randomPrime() (see
+ * RSA.h): the length in bits, the number of top bits set, and a prime e that p-1
+ * must not be a multiple of (or 0).  reserve() registers a class and take() registers
+ * any class it is asked for; the producers keep every registered class topped up
+ * to the pool's depth, most depleted class first.  take() only searches inline if
+ * its class has run dry.
+ *
+ * With a cache file the unused primes survive restarts: the constructor loads and
+ * re-checks them, then deletes the file, and the destructor writes whatever is
+ * left.  Nothing else writes the file, so a prime is never handed out twice, even
+ * if the process dies in between (the primes in stock are then lost).  The file
+ * holds secret key material and is created readable by its owner only.  The
+ * destructor may run during static destruction (e.g. for the pool behind
+ * RSA::setPrimePool()), so saving uses nothing thread-local, and the statics a
+ * producer reads in the middle of a search are never destroyed.  Programs should
+ * still clear RSA::setPrimePool() before returning from main.
+ *
+ * All calls may be made from any thread.  See RSA::setPrimePool() for using a pool
+ * from the RSA constructors.
+ *
+ * @class: PrimePool
+ * @namespace: RSAUtil
+ * @file: PrimePool.h
+ * @version: 1.0.0.0
+ * @date: 10/18/2026
+ * **************************************************************************************
+ */
+class PrimePool
+{
+private:
+	//A class of primes: randomPrime(bits, topBits, fixedE).
+	struct PrimeClass
+	{
+		int bits;
+		int topBits;
+		unsigned int fixedE;
+		bool operator<(const PrimeClass&) const;
+	};
+
+	std::map<PrimeClass, std::deque<BigNum> > stock;
+	size_t depth;
+	std::string cacheFile;
+	std::mutex stockLock;
+	std::condition_variable stockLow;
+	bool stopping;
+	std::vector<std::thread> producers;
+
+	void produce();
+	void load();
+	bool save();
+
+	PrimePool(const PrimePool&);
+	PrimePool& operator=(const PrimePool&);
+
+public:
+	/*
+	 * *******************************************************************************
+	 * Constructor.
+	 * @parameter size_t:	Number of primes to keep ready in each class.
+	 * @parameter int:	Number of producer threads.
+	 * @parameter std::string:	Cache file, or empty for none.
+	 * *******************************************************************************
+	 */
+	PrimePool(size_t depth = 8, int threads = 1, const std::string& cacheFile = "");
+
+	/*
+	 * *******************************************************************************
+	 * Destructor.  Stops the producers and saves the unused primes to the cache file.
+	 * *******************************************************************************
+	 */
+	virtual ~PrimePool();
+
+	/*
+	 * *******************************************************************************
+	 * reserve.	Registers a class of primes to keep filled.
+	 * @parameter int:	Length in bits.
+	 * @parameter int:	Number of top bits set.
+	 * @parameter unsigned int:	A prime e with gcd(e, p-1) == 1 required, or 0.
+	 * *******************************************************************************
+	 */
+	void reserve(int, int, unsigned int);
+
+	/*
+	 * *******************************************************************************
+	 * take.	Removes a prime of the given class from the pool and returns it, or
+	 * 			searches for one inline if none is ready.  Same parameters as
+	 * 			reserve(), which is implied.
+	 * *******************************************************************************
+	 */
+	BigNum take(int, int, unsigned int);
+
+	/*
+	 * *******************************************************************************
+	 * available.	Number of primes of the given class ready right now.
+	 * *******************************************************************************
+	 */
+	size_t available(int, int, unsigned int);
+};
+
+}
+
+#endif /*PRIMEPOOL_H_*/
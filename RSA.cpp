@@ -1,123 +1,322 @@
 #include "RSA.h"
 #include "BigInt.h"
+#include "PrimePool.h"
+#include "PrimeBitmap.h"
 #include <cstdlib>
 #include <cmath>
 #include <limits>
 #include <iostream>
 #include <ctime>
+#include <chrono>
+#include <random>
 
 // Author Cynthia Sturton
 
 namespace RSAUtil
 {
 	#define A_MAX 25
-	#define RAND_LIMIT 0xFFFF
-	
-	
+	//Bit length of the primes made by the original constructors.
+	#define SMALL_PRIME_BITS 17
+	//Candidates searched upwards from one random start before starting over.
+	#define PRIME_SEARCH_SPAN 65536
+	//Number of small primes used to sieve candidates.
+	#define SIEVE_PRIMES 2048
+
+// The e of a fixed exponent policy, 0 for EXPONENT_RANDOM.
+static unsigned int fixedExponent(ExponentPolicy policy){
+	switch(policy){
+		case EXPONENT_F4:
+			return 65537;
+		case EXPONENT_3:
+			return 3;
+		default:
+			return 0;
+	}
+}
+
+// The pool behind RSA::setPrimePool(), read and written atomically.
+static std::shared_ptr<PrimePool> primePool;
+
+// A fresh prime for a generated key: from the pool if there is one.
+static BigNum nextPrime(int bits, int topBits, unsigned int fixedE){
+	std::shared_ptr<PrimePool> pool = std::atomic_load(&primePool);
+	if(pool){
+		return pool->take(bits, topBits, fixedE);
+	}
+	return randomPrime(bits, topBits, fixedE);
+}
+
+// The prime sizes and top bits RSA(spec) uses: k primes of bits/k bits, the first
+// (bits % k) of them one bit longer.
+static std::vector<int> primeSizes(const KeySpec& spec, int& topBits){
+	int bits = spec.bits < 32 ? 32 : spec.bits;
+	int k = spec.primes < 2 ? 2 : (spec.primes > 8 ? 8 : spec.primes);
+	if(k > bits/16){
+		k = bits/16;
+	}
+	//With this many top bits set in every prime, the product of the k primes has
+	//exactly the sum of their lengths in bits.
+	topBits = (k == 2) ? 2 : ((k <= 5) ? 3 : 4);
+	std::vector<int> sizes;
+	for(int i=0; i<k; i++){
+		sizes.push_back(bits/k + ((i < bits % k) ? 1 : 0));
+	}
+	return sizes;
+}
+
+// Uniformly random limbs from the system's random device.
+static void randomLimbs(limb_t* r, int count){
+	static thread_local std::random_device device;
+	for(int i=0; i<count; i++){
+		r[i] = ((limb_t)device() << 32) | device();
+	}
+}
+
+// A random number of exactly the given bits with the top topBits bits set.
+static BigNum randomBits(int bits, int topBits){
+	int count = (bits + LIMB_BITS - 1) / LIMB_BITS;
+	std::vector<limb_t> limbs(count);
+	randomLimbs(&limbs[0], count);
+	BigNum response;
+	response.setLimbs(&limbs[0], count);
+	response = response >> (count*LIMB_BITS - bits);
+	BigNum top = ((BigNum(1) << topBits) - 1) << (bits - topBits);
+	BigNum low = response - (response >> (bits - topBits) << (bits - topBits));
+	return top + low;
+}
+
+// The first SIEVE_PRIMES odd primes.
+static std::vector<unsigned int> firstOddPrimes(){
+	std::vector<unsigned int> primes;
+	for(unsigned int c=3; primes.size()<SIEVE_PRIMES; c+=2){
+		bool prime = true;
+		for(size_t i=0; prime && i<primes.size() && primes[i]*primes[i]<=c; i++){
+			prime = (c % primes[i] != 0);
+		}
+		if(prime){
+			primes.push_back(c);
+		}
+	}
+	return primes;
+}
+
+// Never destroyed: a prime pool's producers may still be searching while the statics
+// are torn down at exit (see PrimePool.h).
+static const std::vector<unsigned int>& sievePrimes(){
+	static const std::vector<unsigned int>& primes = *new std::vector<unsigned int>(firstOddPrimes());
+	return primes;
+}
+
+// Miller-Rabin rounds for an error probability below 2^-80 (as in FIPS 186-4).
+static int millerRabinRounds(int bits){
+	if(bits >= 1300){
+		return 2;
+	}
+	if(bits >= 850){
+		return 3;
+	}
+	if(bits >= 650){
+		return 4;
+	}
+	if(bits >= 350){
+		return 8;
+	}
+	if(bits >= 250){
+		return 12;
+	}
+	if(bits >= 150){
+		return 18;
+	}
+	return 27;
+}
+
 RSA::RSA(int p1, int q1){
 	RSA::e = 0;
 	RSA::d = 0;
-	RSA::p = p1;
-	RSA::q = q1;
+	RSA::policy = EXPONENT_F4;
+	RSA::keyGenMs = 0;
+	RSA::primes.push_back(BigNum(p1));
+	RSA::primes.push_back(BigNum(q1));
 	
 	srand(time(0));
-	RSA::n = BigInt(RSA::p)*BigInt(RSA::q);
-	RSA::phi = BigInt(((RSA::p)-1))*BigInt(((RSA::q)-1));
+	calcN();
 }
 
 RSA::RSA(int p1){
-	bool isP;
 	RSA::e = 0;
 	RSA::d = 0;
-	RSA::p = p1;
+	RSA::policy = EXPONENT_F4;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	RSA::primes.push_back(BigNum(p1));
 	
 	srand(time(0));
 	
-	//Find q that is prime and not equal to p.  Check that p!=q first 
-
+	//Find q that is prime and not equal to p.
+	BigNum q;
 	do{ 
-		RSA::q = int(((double)std::rand()/RAND_MAX)*RAND_LIMIT);
-		//set the low bit and high bit.
-		RSA::q = RSA::q | 0x10001;
-		isP = isPrime(RSA::q);
-	
-	}while((RSA::p==RSA::q) || !isP);
-	
-	
-	RSA::n = BigInt(RSA::p)*BigInt(RSA::q);
-	RSA::phi = BigInt(((RSA::p)-1))*BigInt(((RSA::q)-1));
-	
+		q = nextPrime(SMALL_PRIME_BITS, 1, fixedExponent(RSA::policy));
+	}while(q == RSA::primes[0]);
+	RSA::primes.push_back(q);
+	calcN();
+	RSA::keyGenMs = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - start).count();
 }
 
 RSA::RSA()
 {
-	bool isP;
 	RSA::e = 0;
 	RSA::d = 0;
+	RSA::policy = EXPONENT_F4;
+	srand(time(0));
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 	
 	//find p & q, s.t. p!=q && p and q are both prime.
-	
+	do{
+		RSA::primes.clear();
+		RSA::primes.push_back(nextPrime(SMALL_PRIME_BITS, 1, fixedExponent(RSA::policy)));
+		RSA::primes.push_back(nextPrime(SMALL_PRIME_BITS, 1, fixedExponent(RSA::policy)));
+	}while(RSA::primes[0] == RSA::primes[1]);
+	calcN();
+	RSA::keyGenMs = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - start).count();
+}
+
+RSA::RSA(const KeySpec& spec)
+{
+	RSA::e = 0;
+	RSA::d = 0;
+	RSA::policy = spec.exponent;
 	srand(time(0));
-	
-	
-	do{	
-		RSA::p = int(((double)std::rand()/RAND_MAX)*RAND_LIMIT);
-	
-		// Set low bit (for oddness) and high bit (to make sure it is large enough).
-		RSA::p = RSA::p | 0x10001;
-		isP = isPrime(RSA::p);
-	}while(!isP);
-	
-	
-	//Find q that is prime and not equal to p.  Check that p!=q first since
-	//that is the easier check.
-	do{ 
-		RSA::q = int(((double)std::rand()/RAND_MAX)*RAND_LIMIT);
-		//set the low bit and high bit.
-		RSA::q = RSA::q | 0x10001;
-		isP = isPrime(RSA::q);
-	
-	}while((RSA::p==RSA::q) || !isP);
-	
-	
-	RSA::n = BigInt(RSA::p)*BigInt(RSA::q);
-	RSA::phi = BigInt(((RSA::p)-1))*BigInt(((RSA::q)-1));
+	generate(spec);
+}
+
+RSA::RSA(const std::vector<BigNum>& factors)
+{
+	RSA::e = 0;
+	RSA::d = 0;
+	RSA::policy = EXPONENT_F4;
+	RSA::keyGenMs = 0;
+	RSA::primes = factors;
+
+	srand(time(0));
+	calcN();
 }
 
 RSA::~RSA()
 {
 }
+
+void RSA::generate(const KeySpec& spec){
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	int topBits;
+	std::vector<int> sizes = primeSizes(spec, topBits);
+
+	//find distinct primes of the given sizes.
+	while(RSA::primes.size() < sizes.size()){
+		BigNum r = nextPrime(sizes[RSA::primes.size()], topBits, fixedExponent(RSA::policy));
+		bool isNew = true;
+		for(size_t i=0; i<RSA::primes.size(); i++){
+			isNew = isNew && !(RSA::primes[i] == r);
+		}
+		if(isNew){
+			RSA::primes.push_back(r);
+		}
+	}
+	calcN();
+	calcD();
+	RSA::keyGenMs = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - start).count();
+}
+
+void RSA::setPrimePool(const std::shared_ptr<PrimePool>& pool){
+	if(pool){
+		pool->reserve(SMALL_PRIME_BITS, 1, fixedExponent(EXPONENT_F4));
+	}
+	std::atomic_store(&primePool, pool);
+}
+
+std::shared_ptr<PrimePool> RSA::getPrimePool(){
+	return std::atomic_load(&primePool);
+}
+
+void RSA::reservePrimes(const KeySpec& spec){
+	std::shared_ptr<PrimePool> pool = std::atomic_load(&primePool);
+	if(!pool){
+		return;
+	}
+	int topBits;
+	std::vector<int> sizes = primeSizes(spec, topBits);
+	for(size_t i=0; i<sizes.size(); i++){
+		pool->reserve(sizes[i], topBits, fixedExponent(spec.exponent));
+	}
+}
+
+void RSA::calcN(){
+	RSA::n = 1;
+	RSA::phi = 1;
+	for(size_t i=0; i<RSA::primes.size(); i++){
+		RSA::n *= RSA::primes[i];
+		RSA::phi *= RSA::primes[i] - 1;
+	}
+}
+
 void RSA::setPublicKey(unsigned int pubKey){
-	RSA::e = pubKey;
+	RSA::e = (unsigned long long)pubKey;
+	//d belongs to the old e.
+	RSA::d = 0;
+	RSA::pub.reset();
+	RSA::priv.reset();
 }
 
 // The 2  functions below added by Raghunathan Srinivasan
-void RSA::setN(BigInt B)
+void RSA::setN(const BigNum& B)
 {
 RSA::n = B;
+RSA::pub.reset();
+RSA::priv.reset();
 
 }
 
 
 // end of func 
 // overloaded function created by Raghu
-void RSA::setPublicKey(BigInt B)
+void RSA::setPublicKey(const BigNum& B)
 {
 RSA::e = B;
+RSA::d = 0;
+RSA::pub.reset();
+RSA::priv.reset();
 }
 // end of code addition
 
 
+void RSA::setExponentPolicy(ExponentPolicy newPolicy){
+	RSA::policy = newPolicy;
+	RSA::e = 0;
+	RSA::d = 0;
+	RSA::pub.reset();
+	RSA::priv.reset();
+}
 
+ExponentPolicy RSA::getExponentPolicy() const{
+	return RSA::policy;
+}
 
-int RSA::getP() const{
-	return RSA::p;
+
+BigNum RSA::getP() const{
+	return RSA::primes.size() > 0 ? RSA::primes[0] : BigNum();
+}
+BigNum RSA::getQ() const{
+	return RSA::primes.size() > 1 ? RSA::primes[1] : BigNum();
 }
-int RSA::getQ() const{
-	return RSA::q;
+const std::vector<BigNum>& RSA::getPrimes() const{
+	return RSA::primes;
+}
+double RSA::getKeyGenTime() const{
+	return RSA::keyGenMs;
 }
 
-BigInt RSA::getPublicKey(){
+BigNum RSA::getPublicKey(){
 	//If e has not been set, calculate e, o/w just return it.
 	if(RSA::e.isZero()){
 		calcE();
@@ -125,7 +324,7 @@ BigInt RSA::getPublicKey(){
 	return RSA::e;
 }
 
-BigInt RSA::getPrivateKey(){
+BigNum RSA::getPrivateKey(){
 	//If d has not been set, calculate d, o/w just return it.
 	if(RSA::d.isZero()){
 		calcD();
@@ -133,35 +332,49 @@ BigInt RSA::getPrivateKey(){
 	return RSA::d;
 }
 
-BigInt RSA::getPHI() const{
+BigNum RSA::getPHI() const{
 	return RSA::phi;
 }
-BigInt RSA::getModulus() const{
+BigNum RSA::getModulus() const{
 	return RSA::n;
 }
 
 //calculates m^e mod n
-BigInt RSA::encrypt(BigInt msg){
-	BigInt cipher;
-	
+BigNum RSA::encrypt(const BigNum& msg){
+	if(!RSA::pub){
+		RSA::pub = std::make_shared<const PublicKey>(buildPublicKey());
+	}
+	return RSA::pub->encrypt(msg);
+}
+
+//calculates c^d mod n
+BigNum RSA::decrypt(const BigNum& cipher){
+	if(!RSA::priv){
+		RSA::priv = std::make_shared<const PrivateKey>(buildPrivateKey());
+	}
+	return RSA::priv->decrypt(cipher);
+}
+
+PublicKey RSA::buildPublicKey(){
 	if(RSA::e.isZero()){
 		calcE();
 	}
-	cipher = RSAUtil::modPow(msg, RSA::e, RSA::n);
-	return cipher;
+	return PublicKey(RSA::n, RSA::e);
 }
 
-//calculates c^d mod n
-BigInt RSA::decrypt(BigInt cipher){
-	BigInt message;
+PrivateKey RSA::buildPrivateKey(){
 	if(RSA::d.isZero()){
 		calcD();
 	}
-
-	//Do decryption
-	message = RSAUtil::modPow(cipher, RSA::d, RSA::n);
-	
-	return message;
+	//The factors only help while n has not been replaced through setN().
+	BigNum product(1);
+	for(size_t i=0; i<RSA::primes.size(); i++){
+		product *= RSA::primes[i];
+	}
+	if(RSA::primes.size() >= 2 && RSA::n == product){
+		return PrivateKey(RSA::primes, RSA::e, RSA::d);
+	}
+	return PrivateKey(RSA::n, RSA::e, RSA::d);
 }
 
 /** test code by raghu */
@@ -172,24 +385,33 @@ BigInt RSA::decrypt(BigInt cipher){
 	
 void RSA::calcE(){
 	
+	//A fixed e only has to be relatively prime to PHI.
+	unsigned int fixedE = fixedExponent(RSA::policy);
+	if(fixedE != 0 && gcd(RSA::phi, BigNum(fixedE)) == 1){
+		RSA::e = (unsigned long long)fixedE;
+		return;
+	}
+
 	//Find e such that 1 < e < PHI, and e is relatively prime to PHI
-	BigInt r;
+	BigNum r;
 	unsigned int high, low;
 	bool done = false;
-	BigInt tempPhi;
-	tempPhi = RSA::phi;
+	BigNum lowest = RSA::phi/6;
+	BigNum highest = lowest*5;
+	bool wide = !(lowest < (BigNum(3) << 32));
 	
 	while(!done){
 		//need to generate a 32-34 bit random number.  
 		//generate 32 bit random num.
 		//add 33rd bit.  either 0,1,or 2.
-		low = int(((double)std::rand()/RAND_MAX)*0xFFFFFFFF);
-		high = int(((double)std::rand()/RAND_MAX)*0x02);
-		r = BigInt(high,low);
+		low = (unsigned int)(((double)std::rand()/RAND_MAX)*0xFFFFFFFF);
+		high = (unsigned int)(((double)std::rand()/RAND_MAX)*0x02);
+		r = (BigNum(high) << 32) + low;
 			
-		//Make sure r is in the middle 2/3 of PHI.
-		if((r>(RSA::phi/6)) && r<((RSA::phi/6)*5) ){
-			r |= 0x01;
+		//Make sure r is in the middle 2/3 of PHI.  A large PHI is beyond the
+		//range of r, so there r only has to be above 1.
+		if(wide ? (r > 1) : ((r > lowest) && r < highest) ){
+			r = r.isOdd() ? r : r + 1;
 			done = (gcd(RSA::phi, r) == 1);
 		}
 	}//end while loop.
@@ -201,14 +423,11 @@ void RSA::calcE(){
 void RSA::calcD(){
 
 	//Find d such that de = 1 (mod PHI).  d exists if e and PHI are relatively prime.
-	BigInt response;
-	
 	if(RSA::e.isZero()){
 		calcE();
 	}
 	
-	response = modInverse(RSA::e, RSA::phi);
-	RSA::d = response;
+	RSA::d = modInverse(RSA::e, RSA::phi);
 }
 
 
@@ -223,6 +442,10 @@ void RSA::calcD(){
 //Composite testing.
 bool isPrime(int p){
 	
+	const PrimeBitmap* bitmap = PrimeBitmap::shared();
+	if(bitmap && p >= 0){
+		return bitmap->isPrime((unsigned int)p);
+	}
 	bool isP;
 	//Check if it is divisible by a small prime.
 	isP = isPrimeDiv(p);
@@ -286,7 +509,7 @@ bool isPrimeMR(int p){
 		j++;
 	
 		while(j<b && !(z==(p-1)) && !(z==1)){
-			z = modPow(z, (unsigned int)2, (unsigned int)p);
+			z = z.sqr() % p;
 			j++;
 		}
 		if(z == 1){
@@ -327,6 +550,120 @@ bool isPrimeDiv(int p){
 }
 
 
+bool isPrime(const BigNum& p){
+	if(p < 2){
+		return false;
+	}
+	const PrimeBitmap* bitmap = PrimeBitmap::shared();
+	if(bitmap && p.size() == 1 && p.limbs()[0] <= 0xFFFFFFFFULL){
+		return bitmap->isPrime((unsigned int)p.limbs()[0]);
+	}
+	//Trial division; small p are settled here.
+	const std::vector<unsigned int>& small = sievePrimes();
+	if(!p.isOdd()){
+		return p == 2;
+	}
+	for(size_t i=0; i<small.size(); i++){
+		if(p == (unsigned long long)small[i]){
+			return true;
+		}
+		if(BigNum::divModWord(0, p, small[i]) == 0){
+			return false;
+		}
+	}
+	BigNum limit = (unsigned long long)small.back();
+	if(p <= limit*limit){
+		return true;
+	}
+
+	//Miller-Rabin: p-1 = m*2^b with m odd.
+	BigNum pMinus1 = p - 1;
+	int b = 0;
+	while(!pMinus1[b]){
+		b++;
+	}
+	BigNum m = pMinus1 >> b;
+	MontContext ctx(p);
+	int rounds = millerRabinRounds(p.bitLength());
+
+	for(int iter=0; iter<rounds; iter++){
+		//Base 2 first, then random bases in [2, p-2].
+		BigNum a(2);
+		if(iter > 0){
+			a = randomBits(p.bitLength(), 1) % (p - 3) + 2;
+		}
+		BigNum z = ctx.pow(a, m);
+		if(z == 1 || z == pMinus1){
+			continue;
+		}
+		int j = 1;
+		while(j < b && !(z == pMinus1) && !(z == 1)){
+			z = (z*z) % p;
+			j++;
+		}
+		if(!(z == pMinus1)){
+			return false;
+		}
+	}
+	return true;
+}
+
+BigNum randomPrime(int bits, int topBits, unsigned int fixedE){
+	//Up to 32 bits the prime is picked straight from the bitmap.
+	const PrimeBitmap* bitmap = PrimeBitmap::shared();
+	if(bitmap && bits <= 32){
+		unsigned long long lo = ((1ULL << topBits) - 1) << (bits - topBits);
+		unsigned long long hi = (1ULL << bits) - 1;
+		unsigned int p = bitmap->randomPrime((unsigned int)lo, (unsigned int)hi, fixedE);
+		if(p){
+			return BigNum((unsigned long long)p);
+		}
+	}
+	const std::vector<unsigned int>& small = sievePrimes();
+	//Primes below 2^(bits-1) cannot be candidates themselves, so any of them dividing a
+	//candidate proves it composite.
+	size_t sieveCount = small.size();
+	if(bits <= 32){
+		while(sieveCount > 0 && small[sieveCount-1] >= (1ULL << (bits-1))){
+			sieveCount--;
+		}
+	}
+	std::vector<unsigned int> residue(sieveCount);
+
+	for(;;){
+		BigNum start = randomBits(bits, topBits);
+		if(!start.isOdd()){
+			start += 1;
+		}
+		for(size_t i=0; i<sieveCount; i++){
+			residue[i] = BigNum::divModWord(0, start, small[i]);
+		}
+		unsigned int eResidue = fixedE ? BigNum::divModWord(0, start, fixedE) : 0;
+
+		for(unsigned int delta=0; delta<PRIME_SEARCH_SPAN; delta+=2){
+			bool candidate = true;
+			for(size_t i=0; candidate && i<sieveCount; i++){
+				candidate = ((residue[i] + delta) % small[i] != 0);
+			}
+			//gcd(e, p-1) == 1 for a prime e means p != 1 mod e.
+			if(candidate && fixedE){
+				candidate = ((eResidue + delta) % fixedE != 1);
+			}
+			if(!candidate){
+				continue;
+			}
+			BigNum p = start + (unsigned long long)delta;
+			//The search must not run past the top bits or the length.
+			if(p.bitLength() != bits || (p >> (bits - topBits)) != (BigNum(1) << topBits) - 1){
+				break;
+			}
+			if(isPrime(p)){
+				return p;
+			}
+		}
+	}
+}
+
 int gcd(int i, int j){
 	if(j == 0){
 		return i;
@@ -338,19 +675,41 @@ int gcd(int i, int j){
 }
 
 BigInt gcd(BigInt i, BigInt j){
-	if(j==0){
+	unsigned long long iw, jw;
+	if(i.toWord(iw) && j.toWord(jw)){
+		return BigInt(std::bitset<BIGINT_SIZE>(wordGcd(iw, jw)));
+	}
+	if(i.isZero()){
+		return j;
+	}
+	if(j.isZero()){
 		return i;
 	}
-	else{
-		return gcd(j, i%j);
+	//Binary gcd: strip the factors of two with lowestSetBit, then subtract.
+	int iz = i.lowestSetBit(), jz = j.lowestSetBit();
+	int shift = (iz < jz) ? iz : jz;
+	i >>= iz;
+	while(!j.isZero()){
+		j >>= j.lowestSetBit();
+		if(i > j){
+			BigInt t = i;
+			i = j;
+			j = t;
+		}
+		j = j - i;
 	}
-	
+	i <<= shift;
+	return i;
 }
 
 //extended Euclidean algorithm.  Find b s.t. ab = 1 mod m
 BigInt modInverse(BigInt a, BigInt m){
 	bool neg = false;
 	BigInt b;
+	unsigned long long aw, mw;
+	if(a.toWord(aw) && m.toWord(mw) && mw != 0){
+		return BigInt(std::bitset<BIGINT_SIZE>(wordModInverse(aw, mw)));
+	}
 	BigInt u1,u2,u3,v1,v2,v3,t1,t2,t3,q;
 	u1 = 1;
 	u2 = 0;
@@ -363,9 +722,9 @@ BigInt modInverse(BigInt a, BigInt m){
 	
 	while(!((u3%v3).isZero())){
 		q = (u3/v3);
-		t1 = u1 - (q*v1);
-		t2 = u2 - (q*v2);
-		t3 = u3 - (q*v3);
+		t1 = submul(u1, q, v1);
+		t2 = submul(u2, q, v2);
+		t3 = submul(u3, q, v3);
 		u1 = v1;
 		u2 = v2;
 		u3 = v3;
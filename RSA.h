@@ -1,4 +1,7 @@
 #include "BigInt.h"
+#include "RSAKey.h"
+#include <memory>
+#include <vector>
 
 #ifndef RSA_H_
 #define RSA_H_
@@ -6,15 +9,64 @@
 namespace RSAUtil
 {
 
+class PrimePool;
+
 /****************************************************************************************
- * A class that implements 32-bit encryption using RSA public key encryption.  This class
- * provides methods for generating the public and private keys (Alternately, the public
- * key can be explicitly set) and for RSA encryption and decryption.
- * P and Q are generated randomly (using srand() from <cstdlib>), but they can be
+ * How RSA chooses the public exponent e.
+ * EXPONENT_F4:		e = 65537 (the default).
+ * EXPONENT_3:		e = 3.
+ * EXPONENT_RANDOM:	A random 33-34 bit odd e from the middle of phi, as in the
+ * 					original RSA class.  For compatibility only: every public-key
+ * 					operation then costs a 34-bit exponentiation.
+ * Both fixed exponents have the form 2^k + 1, for which encryption and verification
+ * take k squarings and one multiplication.  If a fixed exponent divides phi (only
+ * possible when the primes were given to the constructor), a random e is used.
+ * **************************************************************************************
+ */
+enum ExponentPolicy
+{
+	EXPONENT_F4,
+	EXPONENT_3,
+	EXPONENT_RANDOM
+};
+
+/****************************************************************************************
+ * Parameters for generating a key.
+ * bits:		Bit length of the modulus n (2048 by default).  n always has exactly
+ * 				this many bits.
+ * primes:		Number of distinct prime factors of n (2 by default, at most 8, and
+ * 				each prime gets at least 16 bits).  With k primes the private
+ * 				operation runs k exponentiations on 1/k-size moduli.
+ * exponent:	How e is chosen.  Primes p with p-1 divisible by a fixed e are
+ * 				skipped.
+ * **************************************************************************************
+ */
+struct KeySpec
+{
+	int bits;
+	int primes;
+	ExponentPolicy exponent;
+
+	KeySpec() : bits(2048), primes(2), exponent(EXPONENT_F4) {}
+	explicit KeySpec(int modulusBits, int k = 2, ExponentPolicy policy = EXPONENT_F4)
+		: bits(modulusBits), primes(k), exponent(policy) {}
+};
+
+/****************************************************************************************
+ * A class that implements RSA public key encryption.  This class provides methods for
+ * generating the public and private keys (Alternately, the public key can be
+ * explicitly set) and for RSA encryption and decryption.
+ * The primes are generated randomly (from std::random_device) to give a modulus of the
+ * bit length in the KeySpec, or 34 bits for the original constructors, but they can be
  * specified in the constructor if desired.  (This feature is used mostly for testing.)
  * Additional helper functions are provided for finding gcd, testing for primality and
  * finding the modular inverse of a number.
  *
+ * An RSA object computes e and d lazily and is not safe to share between threads.
+ * It acts as a builder for the immutable PublicKey and PrivateKey objects (see
+ * RSAKey.h), which are; encrypt() and decrypt() go through such keys, built the first
+ * time they are needed.
+ *
  * @class: RSA
  * @namespace: RSAUtil
  * @file: RSA.h
@@ -26,20 +78,32 @@ namespace RSAUtil
 class RSA
 {
 private:
-	//17 bit randomly generated prime numbers. p != q.
-	unsigned int p, q;
-	//modulus, n=p*q.
-	BigInt n;
-	//totient, phi=(p-1)(q-1).
-	BigInt phi;
+	//all prime factors of n, p and q first.  p != q.  Multi-prime keys have more than
+	//two.
+	std::vector<BigNum> primes;
+	//modulus, n=p*q (the product of all the primes).
+	BigNum n;
+	//totient, phi=(p-1)(q-1) (the product of all the primes less one).
+	BigNum phi;
 	//public key.  gcd(e, phi) == 1.
-	BigInt e;
+	BigNum e;
 	//private key. [ed == 1] mod n.
-	BigInt d;
+	BigNum d;
+	//How calcE() chooses e.
+	ExponentPolicy policy;
+	//Time taken by the constructor to generate the primes, e and d, in milliseconds.
+	double keyGenMs;
+	//Key objects built from the values above.  Dropped when n or e change.
+	std::shared_ptr<const PublicKey> pub;
+	std::shared_ptr<const PrivateKey> priv;
 
 	//Calculate the public and private keys.
 	void calcE();
 	void calcD();
+	//Sets n and phi from the primes.
+	void calcN();
+	//Generates primes for spec and calculates e and d.
+	void generate(const KeySpec&);
 
 
 public:
@@ -49,12 +113,19 @@ public:
 	 * If one int is given as a parametr, it is assigned to p and no checking
 	 * is done on its validity (primeness).  If two ints are given, the first is
 	 * p, the second is q and no testing is done for validity.  The constructor
-	 * initializes n and phi.
+	 * initializes n and phi.  The generated primes are 17 bits long.
+	 * RSA(KeySpec) generates a key of spec.bits bits from spec.primes distinct primes,
+	 * and calculates e and d straight away, so getKeyGenTime() covers the whole key.
+	 * Generated primes come from the prime pool, if one is set (see setPrimePool).
+	 * RSA(primes) takes the primes of a multi-prime key as given, again without
+	 * testing them.
 	 * **********************************************************************************
 	 */
 	RSA();
 	RSA(int);
 	RSA(int, int);
+	RSA(const KeySpec&);
+	RSA(const std::vector<BigNum>&);
 	virtual ~RSA();
 
 	/*
@@ -62,13 +133,16 @@ public:
 	 * Accessor methods.
 	 * *********************************************************************************
 	 */
-	BigInt getPublicKey();
-	BigInt getPrivateKey();
-	BigInt getModulus() const;
+	BigNum getPublicKey();
+	BigNum getPrivateKey();
+	BigNum getModulus() const;
 	//Returns phi, the totient of the modulus.
-	BigInt getPHI() const;
-	int getP() const;
-	int getQ() const;
+	BigNum getPHI() const;
+	BigNum getP() const;
+	BigNum getQ() const;
+	const std::vector<BigNum>& getPrimes() const;
+	//Milliseconds the constructor spent generating the key; 0 if the primes were given.
+	double getKeyGenTime() const;
 
 	/*
 	 * *********************************************************************************
@@ -85,25 +159,59 @@ public:
 	 */
 	void setPublicKey(unsigned int);
 	 // overloaded function for BigInt created by Raghunathan Srinivasan
-	 void setPublicKey(BigInt B);
+	 void setPublicKey(const BigNum& B);
+
+	/*
+	 * ********************************************************************************
+	 * Changes how e is chosen.  Any e and d calculated so far are dropped; an e set
+	 * through setPublicKey() is dropped too.
+	 * @parameter ExponentPolicy: The new policy.
+	 * ********************************************************************************
+	 */
+	void setExponentPolicy(ExponentPolicy);
+	ExponentPolicy getExponentPolicy() const;
 
 	/*
 	 * *********************************************************************************
 	 * Performs public-key encryption/decryption on given message.  Message must
-	 * be <= 32 bits.  Automatic conversion from std::bitset<> or int to BigInt is
+	 * be less than n.  Automatic conversion from BigInt or int to BigNum is
 	 * possible.
 	 * *********************************************************************************
 	 */
-	BigInt encrypt(BigInt);
-	BigInt decrypt(BigInt);
+	BigNum encrypt(const BigNum&);
+	BigNum decrypt(const BigNum&);
+
+	/*
+	 * *********************************************************************************
+	 * Builds immutable key objects from the current values, calculating e and d first
+	 * if they have not been set.  The private key uses the Chinese Remainder Theorem
+	 * over all the primes when n is still their product.  The keys may be shared
+	 * freely between threads.
+	 * *********************************************************************************
+	 */
+	PublicKey buildPublicKey();
+	PrivateKey buildPrivateKey();
 
 /* The following 4 functions inserted by Raghunathan Srinivasan */
 
 
 
-    void setN(BigInt B);
+    void setN(const BigNum& B);
   // Rest of functions deleted for Project
 
+	/*
+	 * *********************************************************************************
+	 * Prime pool (see PrimePool.h).  Once a pool is set, every constructor that
+	 * generates primes takes them from it, which costs O(1) while the pool keeps
+	 * up; a null pool goes back to searching inline.  setPrimePool() reserves the
+	 * primes of the argument-less constructors, and reservePrimes() those RSA(spec)
+	 * will ask for.  Safe to call from any thread.
+	 * *********************************************************************************
+	 */
+	static void setPrimePool(const std::shared_ptr<PrimePool>&);
+	static std::shared_ptr<PrimePool> getPrimePool();
+	static void reservePrimes(const KeySpec&);
+
 };
 
 
@@ -117,7 +225,8 @@ public:
 /*
  * *******************************************************************************
  * Uses the extended Euclidian algorithm to find the modular inverse,
- * b such that [ab == 1] mod m.
+ * b such that [ab == 1] mod m.  Operands that fit in 64 bits use native
+ * arithmetic, and then give 0 if a has no inverse.
  * @parameter BigInt: This is 'a' in the above equation.
  * @parameter BigInt: This is 'm' in the above equation.
  * @returns BigInt: This is 'b' in the above equation.
@@ -129,7 +238,8 @@ BigInt modInverse(BigInt, BigInt);
  * *******************************************************************************
  * Tests for Primality.  This function first checks for divisibility by the first
  * 100 primes and then, if the integer passes that test, uses the Miller-Rabin
- * algorithm for testing for compositeness.
+ * algorithm for testing for compositeness.  With a prime bitmap (see PrimeBitmap.h)
+ * non-negative integers are looked up instead.
  * @parameter int: The integer to be tested for primality.
  * @returns bool: False if the number is composite, True if the number is believed
  * 	to be prime with ??% certainty.
@@ -168,10 +278,39 @@ bool isPrimeDiv(int);
  */
 int gcd(int, int);
 
+/*
+ * *******************************************************************************
+ * Probabilistic primality test for large numbers: trial division by the small
+ * primes, then Miller-Rabin with base 2 and random bases, as many rounds as needed
+ * for an error probability below 2^-80 at the given size.  Numbers below 2^32 are
+ * looked up in the prime bitmap when there is one.
+ * @parameter BigNum: The number to be tested.
+ * @returns bool: False if the number is composite, True if it is believed to be
+ * 	prime.
+ * *******************************************************************************
+ */
+bool isPrime(const BigNum&);
+
+/*
+ * *******************************************************************************
+ * Generates a random prime of exactly the given number of bits.  The top bits are
+ * all set, so a product of k such primes of b1..bk bits has exactly b1+...+bk bits
+ * when topBits is 2 for k = 2, 3 for k <= 5 and 4 for k <= 8.  Candidates are
+ * searched upwards from a random start, sieving out multiples of small primes
+ * before running isPrime().  Up to 32 bits, with a prime bitmap, the prime is the
+ * first one after a random point in the allowed range instead.
+ * @parameter int: The number of bits (>= 3).
+ * @parameter int: The number of top bits to set (1 to bits-1).
+ * @parameter unsigned int: A prime e with gcd(e, p-1) == 1 required, or 0.
+ * @returns BigNum: The prime.
+ * *******************************************************************************
+ */
+BigNum randomPrime(int, int, unsigned int);
+
 /*
  * *********************************************************************************
  * Recursive function performs Euclidian algorithm for finding the greatest common
- * divisor of two integers.
+ * divisor of two integers.  Operands that fit in 64 bits use the native binary gcd.
  * @parameter BigInt: The first integer.
  * @parameter BigInt: The second integer.
  * @returns BigInt: The greatest common divisor of the first and the second integers.
@@ -0,0 +1,477 @@
+#include "RSADaemon.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <sstream>
+
+//Longest request line accepted before the connection is dropped.
+#define DAEMON_MAX_LINE 65536
+
+namespace RSAUtil
+{
+
+static double nowUs(){
+	return std::chrono::duration<double, std::micro>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Hex without the grouping spaces, so it fits in one protocol field.
+static std::string compactHex(const BigNum& val){
+	std::string hex = val.toHexString();
+	std::string response;
+	for(size_t i=0; i<hex.size(); i++){
+		if(hex[i] != ' '){
+			response += hex[i];
+		}
+	}
+	return response;
+}
+
+// A hex number as ENC, DEC and SIGN take it: digits with an optional 0x prefix.
+static bool isHexArg(const std::string& arg){
+	size_t start = (arg.compare(0, 2, "0x") == 0 || arg.compare(0, 2, "0X") == 0) ? 2 : 0;
+	if(start == arg.size()){
+		return false;
+	}
+	for(size_t i=start; i<arg.size(); i++){
+		if(!std::isxdigit((unsigned char)arg[i])){
+			return false;
+		}
+	}
+	return true;
+}
+
+// The requests STATS counts.
+static bool isKnownOp(const std::string& op){
+	return op == "ENC" || op == "DEC" || op == "SIGN" || op == "PUB" || op == "STATS";
+}
+
+static void setNonBlocking(int fd){
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+RSADaemon::RSADaemon(const std::string& socketPath) : path(socketPath)
+{
+	listenFd = -1;
+	wakeFds[0] = -1;
+	wakeFds[1] = -1;
+	stopping = false;
+	batchWindowUs = 0;
+	maxBatch = 64;
+	nextConn = 0;
+	batches = 0;
+	batchedRequests = 0;
+	maxQueue = 0;
+	if(pipe(wakeFds) == 0){
+		setNonBlocking(wakeFds[0]);
+		setNonBlocking(wakeFds[1]);
+	}
+}
+
+RSADaemon::~RSADaemon()
+{
+	for(std::map<long, Connection>::iterator it=conns.begin(); it!=conns.end(); ++it){
+		::close(it->second.fd);
+	}
+	if(listenFd >= 0){
+		::close(listenFd);
+		unlink(path.c_str());
+	}
+	if(wakeFds[0] >= 0){
+		::close(wakeFds[0]);
+		::close(wakeFds[1]);
+	}
+}
+
+void RSADaemon::addKey(const std::string& name, const PrivateKey& key){
+	keys.erase(name);
+	keys.insert(std::make_pair(name, key));
+	publicKeys.erase(name);
+	publicKeys.insert(std::make_pair(name, key.getPublicKey()));
+}
+
+void RSADaemon::setBatchWindow(int windowUs, int batchLimit){
+	batchWindowUs = (windowUs > 0) ? windowUs : 0;
+	maxBatch = (batchLimit > 0) ? batchLimit : 1;
+}
+
+void RSADaemon::stop(){
+	stopping = true;
+	if(wakeFds[1] >= 0){
+		char c = 1;
+		ssize_t ignored = write(wakeFds[1], &c, 1);
+		(void)ignored;
+	}
+}
+
+bool RSADaemon::listenSocket(){
+	struct sockaddr_un addr;
+	if(path.size() >= sizeof(addr.sun_path)){
+		return false;
+	}
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	std::strcpy(addr.sun_path, path.c_str());
+
+	listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(listenFd < 0){
+		return false;
+	}
+	unlink(path.c_str());
+	if(bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(listenFd, 128) < 0){
+		::close(listenFd);
+		listenFd = -1;
+		return false;
+	}
+	setNonBlocking(listenFd);
+	return true;
+}
+
+void RSADaemon::acceptClients(){
+	int fd;
+	while((fd = accept(listenFd, 0, 0)) >= 0){
+		setNonBlocking(fd);
+		Connection c;
+		c.fd = fd;
+		c.pending = 0;
+		c.closing = false;
+		conns[nextConn++] = c;
+	}
+}
+
+//Reads what is available and queues every complete line.  False on hang-up.
+bool RSADaemon::readClient(long id, Connection& c){
+	char buf[4096];
+	ssize_t got;
+	double now = nowUs();
+
+	while((got = read(c.fd, buf, sizeof(buf))) > 0){
+		c.in.append(buf, got);
+	}
+	bool open = (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK));
+
+	size_t start = 0;
+	size_t eol;
+	while((eol = c.in.find('\n', start)) != std::string::npos){
+		std::istringstream line(c.in.substr(start, eol - start));
+		Request r;
+		r.conn = id;
+		r.queuedAt = now;
+		line >> r.op >> r.key >> r.arg;
+		queue.push_back(r);
+		c.pending++;
+		start = eol + 1;
+	}
+	c.in.erase(0, start);
+	if(c.in.size() > DAEMON_MAX_LINE){
+		return false;
+	}
+	if(queue.size() > maxQueue){
+		maxQueue = queue.size();
+	}
+	return open;
+}
+
+void RSADaemon::writeClient(Connection& c){
+	while(!c.out.empty()){
+		ssize_t sent = write(c.fd, c.out.data(), c.out.size());
+		if(sent <= 0){
+			if(sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)){
+				return;
+			}
+			c.out.clear();
+			c.closing = true;
+			return;
+		}
+		c.out.erase(0, sent);
+	}
+}
+
+// Everything except the batched private-key operations.
+void RSADaemon::answer(Request& r){
+	if(r.op == "STATS"){
+		r.reply = "OK " + statsLine();
+		return;
+	}
+	if(r.op != "PUB" && r.op != "ENC"){
+		r.reply = "ERR unknown request";
+		return;
+	}
+	std::map<std::string, PrivateKey>::const_iterator key = keys.find(r.key);
+	if(key == keys.end()){
+		r.reply = "ERR unknown key";
+		return;
+	}
+	if(r.op == "ENC" && !isHexArg(r.arg)){
+		r.reply = "ERR bad argument";
+		return;
+	}
+	if(r.op == "PUB"){
+		r.reply = "OK " + compactHex(key->second.getModulus()) + " "
+				+ compactHex(key->second.getPublicExponent());
+	}
+	else{
+		const PublicKey& pub = publicKeys.find(r.key)->second;
+		r.reply = "OK " + compactHex(pub.encrypt(BigNum::fromHex(r.arg)));
+	}
+}
+
+void RSADaemon::record(const Request& r, double now){
+	std::map<std::string, OpStats>::iterator it = ops.find(r.op);
+	if(it == ops.end()){
+		OpStats s;
+		s.count = 0;
+		s.totalUs = 0;
+		s.maxUs = 0;
+		it = ops.insert(std::make_pair(r.op, s)).first;
+	}
+	double us = now - r.queuedAt;
+	it->second.count++;
+	it->second.totalUs += us;
+	if(us > it->second.maxUs){
+		it->second.maxUs = us;
+	}
+}
+
+void RSADaemon::processQueue(){
+	//Group the private-key requests by key, keeping their queue order.
+	std::map<std::string, std::vector<size_t> > batchesByKey;
+	for(size_t i=0; i<queue.size(); i++){
+		Request& r = queue[i];
+		if((r.op == "DEC" || r.op == "SIGN") && !keys.count(r.key)){
+			r.reply = "ERR unknown key";
+		}
+		else if(r.op == "DEC" || r.op == "SIGN"){
+			if(isHexArg(r.arg)){
+				batchesByKey[r.key].push_back(i);
+			}
+			else{
+				r.reply = "ERR bad argument";
+			}
+		}
+		else{
+			answer(r);
+		}
+	}
+	for(std::map<std::string, std::vector<size_t> >::iterator it=batchesByKey.begin();
+			it!=batchesByKey.end(); ++it){
+		std::vector<BigNum> in;
+		for(size_t i=0; i<it->second.size(); i++){
+			in.push_back(BigNum::fromHex(queue[it->second[i]].arg));
+		}
+		std::vector<BigNum> out = keys.find(it->first)->second.decryptBatch(in);
+		for(size_t i=0; i<it->second.size(); i++){
+			queue[it->second[i]].reply = "OK " + compactHex(out[i]);
+		}
+		batches++;
+		batchedRequests += it->second.size();
+	}
+
+	double now = nowUs();
+	for(size_t i=0; i<queue.size(); i++){
+		if(isKnownOp(queue[i].op)){
+			record(queue[i], now);
+		}
+		std::map<long, Connection>::iterator c = conns.find(queue[i].conn);
+		if(c != conns.end()){
+			c->second.out += queue[i].reply + "\n";
+			c->second.pending--;
+		}
+	}
+	queue.clear();
+}
+
+std::string RSADaemon::statsLine() const{
+	std::ostringstream s;
+	s << "queue=" << queue.size() << " max_queue=" << maxQueue
+		<< " batches=" << batches << " batched=" << batchedRequests
+		<< " avg_batch=" << (batches ? (double)batchedRequests / batches : 0.0);
+	for(std::map<std::string, OpStats>::const_iterator it=ops.begin(); it!=ops.end(); ++it){
+		s << " " << it->first << "_count=" << it->second.count
+			<< " " << it->first << "_avg_us=" << it->second.totalUs / it->second.count
+			<< " " << it->first << "_max_us=" << it->second.maxUs;
+	}
+	return s.str();
+}
+
+bool RSADaemon::run(){
+	if(!listenSocket()){
+		return false;
+	}
+	//A client that hangs up early must not kill the daemon.
+	signal(SIGPIPE, SIG_IGN);
+
+	while(!stopping){
+		//fds[i] belongs to connection ids[i - 2].
+		std::vector<struct pollfd> fds;
+		std::vector<long> ids;
+		struct pollfd p;
+		p.fd = wakeFds[0];
+		p.events = POLLIN;
+		fds.push_back(p);
+		p.fd = listenFd;
+		fds.push_back(p);
+		for(std::map<long, Connection>::iterator it=conns.begin(); it!=conns.end(); ++it){
+			//A closing connection is only waiting for its replies; polling it for a
+			//hang-up that has already been seen would spin through the batch window.
+			if(it->second.closing && it->second.out.empty()){
+				continue;
+			}
+			p.fd = it->second.fd;
+			p.events = (it->second.closing ? 0 : POLLIN) | (it->second.out.empty() ? 0 : POLLOUT);
+			fds.push_back(p);
+			ids.push_back(it->first);
+		}
+
+		//Hold a non-empty queue only while its batch window is open.
+		int timeout = -1;
+		if(!queue.empty()){
+			double left = batchWindowUs - (nowUs() - queue[0].queuedAt);
+			timeout = (left > 0) ? (int)(left / 1000) + 1 : 0;
+		}
+		if(poll(&fds[0], fds.size(), timeout) < 0 && errno != EINTR){
+			break;
+		}
+
+		if(fds[0].revents & POLLIN){
+			char buf[64];
+			while(read(wakeFds[0], buf, sizeof(buf)) > 0){
+			}
+		}
+		if(fds[1].revents & POLLIN){
+			acceptClients();
+		}
+		for(size_t i=2; i<fds.size(); i++){
+			std::map<long, Connection>::iterator c = conns.find(ids[i - 2]);
+			if(c == conns.end()){
+				continue;
+			}
+			if(!c->second.closing && (fds[i].revents & (POLLIN | POLLHUP | POLLERR))){
+				if(!readClient(c->first, c->second)){
+					c->second.closing = true;
+				}
+			}
+			if(fds[i].revents & (POLLOUT | POLLHUP | POLLERR)){
+				writeClient(c->second);
+			}
+		}
+
+		if(!queue.empty() && ((int)queue.size() >= maxBatch
+				|| nowUs() - queue[0].queuedAt >= batchWindowUs)){
+			processQueue();
+			for(std::map<long, Connection>::iterator it=conns.begin(); it!=conns.end(); ++it){
+				writeClient(it->second);
+			}
+		}
+
+		for(std::map<long, Connection>::iterator it=conns.begin(); it!=conns.end();){
+			if(it->second.closing && it->second.pending == 0 && it->second.out.empty()){
+				::close(it->second.fd);
+				conns.erase(it++);
+			}
+			else{
+				++it;
+			}
+		}
+	}
+	return true;
+}
+
+RSAClient::RSAClient()
+{
+	fd = -1;
+}
+
+RSAClient::~RSAClient()
+{
+	close();
+}
+
+bool RSAClient::connect(const std::string& socketPath){
+	struct sockaddr_un addr;
+	close();
+	if(socketPath.size() >= sizeof(addr.sun_path)){
+		return false;
+	}
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	std::strcpy(addr.sun_path, socketPath.c_str());
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(fd < 0){
+		return false;
+	}
+	if(::connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0){
+		close();
+		return false;
+	}
+	return true;
+}
+
+void RSAClient::close(){
+	if(fd >= 0){
+		::close(fd);
+		fd = -1;
+	}
+	buffered.clear();
+}
+
+std::string RSAClient::request(const std::string& line){
+	if(fd < 0){
+		return "ERR connection";
+	}
+	std::string msg = line + "\n";
+	size_t off = 0;
+	while(off < msg.size()){
+		ssize_t sent = write(fd, msg.data() + off, msg.size() - off);
+		if(sent <= 0){
+			close();
+			return "ERR connection";
+		}
+		off += sent;
+	}
+	size_t eol;
+	while((eol = buffered.find('\n')) == std::string::npos){
+		char buf[4096];
+		ssize_t got = read(fd, buf, sizeof(buf));
+		if(got <= 0){
+			close();
+			return "ERR connection";
+		}
+		buffered.append(buf, got);
+	}
+	std::string response = buffered.substr(0, eol);
+	buffered.erase(0, eol + 1);
+	return response;
+}
+
+bool RSAClient::call(const std::string& op, const std::string& key, const BigNum& arg,
+		BigNum& result){
+	std::string reply = request(op + " " + key + " " + compactHex(arg));
+	if(reply.compare(0, 3, "OK ") != 0){
+		return false;
+	}
+	result = BigNum::fromHex(reply.substr(3));
+	return true;
+}
+
+bool RSAClient::encrypt(const std::string& key, const BigNum& msg, BigNum& cipher){
+	return call("ENC", key, msg, cipher);
+}
+
+bool RSAClient::decrypt(const std::string& key, const BigNum& cipher, BigNum& msg){
+	return call("DEC", key, cipher, msg);
+}
+
+bool RSAClient::sign(const std::string& key, const BigNum& msg, BigNum& sig){
+	return call("SIGN", key, msg, sig);
+}
+
+}
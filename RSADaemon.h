@@ -0,0 +1,213 @@
+#ifndef RSADAEMON_H_
+#define RSADAEMON_H_
+#include <map>
+#include <string>
+#include <vector>
+#include "RSAKey.h"
+
+namespace RSAUtil
+{
+
+/****************************************************************************************
+ * A local RSA service.  The daemon holds a set of named keys, loaded once, and serves
+ * requests from other processes over a Unix domain socket.  Each request and each
+ * reply is one line of text:
+ *
+ *	ENC <key> <hex>		encrypt with the public key		-> OK <hex>
+ *	DEC <key> <hex>		decrypt with the private key	-> OK <hex>
+ *	SIGN <key> <hex>	sign with the private key		-> OK <hex>
+ *	PUB <key>			public key						-> OK <n hex> <e hex>
+ *	STATS				counters, see below				-> OK name=value ...
+ *
+ * and any failure is answered with "ERR <reason>", e.g. "ERR bad argument" for a
+ * missing <hex> or one that is not hex digits with an optional 0x.  Replies on a
+ * connection come back in request order, so clients may pipeline, and a client that
+ * shuts down its writing side after its last request still gets every reply.
+ *
+ * The daemon is a single-threaded poll() loop.  Everything read in one pass of the
+ * loop (optionally waiting up to the batch window for more) is queued, and the
+ * private-key requests in the queue are handed to PrivateKey::decryptBatch() one
+ * batch per key, which spreads a batch over the machine's cores.  A batch window
+ * therefore trades latency for throughput only on a multi-core machine, and only
+ * when requests arrive faster than one core serves them.  STATS reports the current and peak queue depth, the number and
+ * average size of batches, and for each of the requests above a count with mean and
+ * maximum latency, measured from the moment a request is read to the moment its
+ * reply is ready.
+ *
+ * @class: RSADaemon
+ * @namespace: RSAUtil
+ * @file: RSADaemon.h
+ * @version: 1.0.0.0
+ * @date: 10/18/2026
+ * **************************************************************************************
+ */
+class RSADaemon
+{
+public:
+	struct OpStats
+	{
+		long count;
+		double totalUs;
+		double maxUs;
+	};
+
+	/*
+	 * *******************************************************************************
+	 * Constructor.
+	 * @parameter std::string:	Path of the Unix domain socket to listen on.  Any
+	 * 							existing file at that path is removed.
+	 * *******************************************************************************
+	 */
+	RSADaemon(const std::string&);
+	virtual ~RSADaemon();
+
+	/*
+	 * *******************************************************************************
+	 * addKey.	Registers a key under the given name.  Must be called before run().
+	 * *******************************************************************************
+	 */
+	void addKey(const std::string&, const PrivateKey&);
+
+	/*
+	 * *******************************************************************************
+	 * setBatchWindow.	After the first request of a batch arrives, keep reading for up
+	 * 					to this many microseconds (default 0: take only what is
+	 * 					already there) or until maxBatch requests are queued.
+	 * *******************************************************************************
+	 */
+	void setBatchWindow(int, int);
+
+	/*
+	 * *******************************************************************************
+	 * run.	Binds the socket and serves requests until stop() is called.
+	 * @returns bool:	False if the socket could not be set up.
+	 * *******************************************************************************
+	 */
+	bool run();
+
+	/*
+	 * *******************************************************************************
+	 * stop.	Makes run() return.  Safe to call from another thread or from a signal
+	 * 			handler.
+	 * *******************************************************************************
+	 */
+	void stop();
+
+	/*
+	 * *******************************************************************************
+	 * statsLine.	The STATS reply, without the leading "OK ".
+	 * *******************************************************************************
+	 */
+	std::string statsLine() const;
+
+private:
+	struct Connection
+	{
+		int fd;
+		std::string in;
+		std::string out;
+		//Requests read from this connection that are still in the queue.
+		int pending;
+		//Set once the client has hung up or misbehaved; closed when nothing is
+		//pending and out is empty.
+		bool closing;
+	};
+
+	struct Request
+	{
+		//Id of the connection it came from.  Ids are never reused, unlike fds, so a
+		//reply can never reach a later connection that got the same fd.
+		long conn;
+		std::string op;
+		std::string key;
+		std::string arg;
+		double queuedAt;
+		std::string reply;
+	};
+
+	std::string path;
+	int listenFd;
+	int wakeFds[2];
+	volatile bool stopping;
+	int batchWindowUs;
+	int maxBatch;
+
+	std::map<std::string, PrivateKey> keys;
+	//The matching public keys, built once for ENC.
+	std::map<std::string, PublicKey> publicKeys;
+	//Open connections by id.
+	std::map<long, Connection> conns;
+	long nextConn;
+	std::vector<Request> queue;
+
+	long batches;
+	long batchedRequests;
+	size_t maxQueue;
+	std::map<std::string, OpStats> ops;
+
+	bool listenSocket();
+	void acceptClients();
+	bool readClient(long, Connection&);
+	void writeClient(Connection&);
+	void processQueue();
+	void answer(Request&);
+	void record(const Request&, double);
+
+	RSADaemon(const RSADaemon&);
+	RSADaemon& operator=(const RSADaemon&);
+};
+
+/****************************************************************************************
+ * A blocking client for RSADaemon.  Each call sends one request and waits for its
+ * reply.
+ *
+ * @class: RSAClient
+ * **************************************************************************************
+ */
+class RSAClient
+{
+public:
+	RSAClient();
+	virtual ~RSAClient();
+
+	/*
+	 * *******************************************************************************
+	 * connect.	Connects to the daemon listening at the given socket path.
+	 * @returns bool:	False if the connection failed.
+	 * *******************************************************************************
+	 */
+	bool connect(const std::string&);
+	void close();
+
+	/*
+	 * *******************************************************************************
+	 * request.	Sends one request line (without the newline) and returns the reply
+	 * 			line, or "ERR connection" if the daemon could not be reached.
+	 * *******************************************************************************
+	 */
+	std::string request(const std::string&);
+
+	/*
+	 * *******************************************************************************
+	 * Typed forms of the ENC, DEC and SIGN requests.
+	 * @returns bool:	False if the daemon answered with an error; the result is then
+	 * 					left unchanged.
+	 * *******************************************************************************
+	 */
+	bool encrypt(const std::string&, const BigNum&, BigNum&);
+	bool decrypt(const std::string&, const BigNum&, BigNum&);
+	bool sign(const std::string&, const BigNum&, BigNum&);
+
+private:
+	int fd;
+	std::string buffered;
+
+	bool call(const std::string&, const std::string&, const BigNum&, BigNum&);
+
+	RSAClient(const RSAClient&);
+	RSAClient& operator=(const RSAClient&);
+};
+
+}
+
+#endif /*RSADAEMON_H_*/
@@ -0,0 +1,309 @@
+#include "RSAKey.h"
+#include "SpinWorker.h"
+#include <algorithm>
+#include <thread>
+
+namespace RSAUtil
+{
+
+// The worker behind PrivateKey::setLowLatency(), read and written atomically; null
+// while the mode is off.
+static std::shared_ptr<SpinWorker> lowLatencyWorker;
+
+// Montgomery context for an odd modulus > 1, or null.
+static std::shared_ptr<const MontContext> montFor(const BigNum& m){
+	if(!m.isOdd() || m == 1){
+		return std::shared_ptr<const MontContext>();
+	}
+	return std::make_shared<const MontContext>(m);
+}
+
+PublicKey::PublicKey(const BigNum& modulus, const BigNum& exponent)
+	: n(modulus), e(exponent)
+{
+	mont = montFor(n);
+	BigNum em1 = e - 1;
+	int k = em1.bitLength() - 1;
+	fermatBits = (k >= 1 && em1 == (BigNum(1) << k)) ? k : 0;
+}
+
+PublicKey::~PublicKey()
+{
+}
+
+const BigNum& PublicKey::getModulus() const{
+	return n;
+}
+
+const BigNum& PublicKey::getExponent() const{
+	return e;
+}
+
+//calculates m^e mod n
+BigNum PublicKey::encrypt(const BigNum& msg) const{
+	if(mont && fermatBits){
+		return mont->powFermat(msg, fermatBits);
+	}
+	if(mont){
+		return mont->pow(msg, e);
+	}
+	return modPow(msg, e, n);
+}
+
+bool PublicKey::verify(const BigNum& msg, const BigNum& sig) const{
+	return encrypt(sig) == msg;
+}
+
+// Screens entries lo..hi-1, bisecting on failure; failed indices go to bad.
+static void verifyRange(const PublicKey& key, const std::vector<BigNum>& msgs,
+		const std::vector<BigNum>& sigs, size_t lo, size_t hi, std::vector<size_t>& bad){
+	if(hi - lo == 1){
+		if(!key.verify(msgs[lo], sigs[lo])){
+			bad.push_back(lo);
+		}
+		return;
+	}
+	const BigNum& n = key.getModulus();
+	BigNum sigProd(1);
+	BigNum msgProd(1);
+	for(size_t i=lo; i<hi; i++){
+		BigNum::mul(sigProd, sigProd, sigs[i]);
+		BigNum::divMod(0, &sigProd, sigProd, n);
+		BigNum::mul(msgProd, msgProd, msgs[i]);
+		BigNum::divMod(0, &msgProd, msgProd, n);
+	}
+	//A signature sharing a factor with n can make both products 0 (e.g. p and q
+	//as signatures), which would pass any forgery alongside; the product is
+	//invertible exactly when every signature is, so one gcd screens the range.
+	if(gcd(sigProd, n) == 1 && key.encrypt(sigProd) == msgProd){
+		return;
+	}
+	size_t mid = lo + (hi - lo)/2;
+	verifyRange(key, msgs, sigs, lo, mid, bad);
+	verifyRange(key, msgs, sigs, mid, hi, bad);
+}
+
+std::vector<size_t> PublicKey::verifyBatch(const std::vector<BigNum>& msgs,
+		const std::vector<BigNum>& sigs) const{
+	std::vector<size_t> bad;
+	std::vector<BigNum> m;
+	std::vector<BigNum> s;
+	std::vector<size_t> index;
+
+	//A message >= n can never verify, but would pass screening once reduced.  A
+	//zero message or a signature that is 0 mod n zeroes the products, so those
+	//entries are checked on their own.
+	for(size_t i=0; i<msgs.size(); i++){
+		if(i >= sigs.size() || msgs[i] >= n){
+			bad.push_back(i);
+		}
+		else if(msgs[i].isZero() || (sigs[i] % n).isZero()){
+			if(!verify(msgs[i], sigs[i])){
+				bad.push_back(i);
+			}
+		}
+		else{
+			m.push_back(msgs[i]);
+			s.push_back(sigs[i]);
+			index.push_back(i);
+		}
+	}
+	if(m.empty()){
+		return bad;
+	}
+	std::vector<size_t> failed;
+	verifyRange(*this, m, s, 0, m.size(), failed);
+	for(size_t i=0; i<failed.size(); i++){
+		bad.push_back(index[failed[i]]);
+	}
+	std::sort(bad.begin(), bad.end());
+	return bad;
+}
+
+PrivateKey::PrivateKey(const BigNum& p1, const BigNum& q1, const BigNum& pubExp,
+		const BigNum& privExp)
+	: n(p1*q1), e(pubExp), d(privExp)
+{
+	primes.push_back(p1);
+	primes.push_back(q1);
+	precompute();
+}
+
+PrivateKey::PrivateKey(const std::vector<BigNum>& factors, const BigNum& pubExp,
+		const BigNum& privExp)
+	: n(1), e(pubExp), d(privExp), primes(factors)
+{
+	for(size_t i=0; i<primes.size(); i++){
+		n *= primes[i];
+	}
+	precompute();
+}
+
+PrivateKey::PrivateKey(const BigNum& modulus, const BigNum& pubExp, const BigNum& privExp)
+	: n(modulus), e(pubExp), d(privExp)
+{
+	precompute();
+}
+
+PrivateKey::~PrivateKey()
+{
+}
+
+void PrivateKey::precompute(){
+	//CRT needs at least two odd factors > 1 that are pairwise coprime; the
+	//coefficients below only exist when they are.
+	bool crt = (primes.size() >= 2);
+	BigNum prefix(1);
+	for(size_t i=0; crt && i<primes.size(); i++){
+		const BigNum& r = primes[i];
+		if(!r.isOdd() || r == 1){
+			crt = false;
+			break;
+		}
+		CRTPrime cp;
+		cp.prime = r;
+		cp.exp = d % (r - 1);
+		cp.prefix = prefix;
+		if(i > 0){
+			cp.coeff = modInverse(prefix % r, r);
+			crt = !cp.coeff.isZero();
+		}
+		cp.mont = montFor(r);
+		crtPrimes.push_back(cp);
+		prefix *= r;
+	}
+	if(!crt){
+		crtPrimes.clear();
+		montN = montFor(n);
+	}
+}
+
+const BigNum& PrivateKey::getModulus() const{
+	return n;
+}
+
+const BigNum& PrivateKey::getPublicExponent() const{
+	return e;
+}
+
+const BigNum& PrivateKey::getExponent() const{
+	return d;
+}
+
+BigNum PrivateKey::getP() const{
+	return primes.size() > 0 ? primes[0] : BigNum();
+}
+
+BigNum PrivateKey::getQ() const{
+	return primes.size() > 1 ? primes[1] : BigNum();
+}
+
+const std::vector<BigNum>& PrivateKey::getPrimes() const{
+	return primes;
+}
+
+bool PrivateKey::usesCRT() const{
+	return !crtPrimes.empty();
+}
+
+//calculates c^d mod n
+BigNum PrivateKey::decrypt(const BigNum& cipher) const{
+	//A single limb modulus is cheaper as one native exponentiation than as CRT.
+	if(n.size() <= 1){
+		return modPow(cipher, d, n);
+	}
+	if(crtPrimes.empty()){
+		if(montN){
+			return montN->pow(cipher, d);
+		}
+		return modPow(cipher, d, n);
+	}
+	//One exponentiation per prime; in low latency mode the worker takes every
+	//other one.
+	std::vector<BigNum> powers(crtPrimes.size());
+	CRTJob mine = {&crtPrimes, &cipher, &powers, 0, 2};
+	CRTJob theirs = {&crtPrimes, &cipher, &powers, 1, 2};
+	std::shared_ptr<SpinWorker> worker = std::atomic_load(&lowLatencyWorker);
+	if(!worker || !worker->tryRun(crtPowers, &theirs)){
+		worker.reset();
+		mine.step = 1;
+	}
+	crtPowers(&mine);
+	if(worker){
+		worker->wait();
+	}
+
+	//Garner's recombination: with m correct modulo the product R of the primes
+	//before r, h = (m_r - m)*R^-1 mod r and m + h*R is correct modulo R*r.
+	BigNum m = powers[0];
+	for(size_t i=1; i<crtPrimes.size(); i++){
+		const CRTPrime& cp = crtPrimes[i];
+		const BigNum& mr = powers[i];
+		BigNum h = mr + cp.prime - (m % cp.prime);
+		h = (h * cp.coeff) % cp.prime;
+		m += h * cp.prefix;
+	}
+	return m;
+}
+
+void PrivateKey::crtPowers(void* arg){
+	CRTJob& job = *(CRTJob*)arg;
+	for(size_t i=job.first; i<job.primes->size(); i+=job.step){
+		const CRTPrime& cp = (*job.primes)[i];
+		(*job.out)[i] = cp.mont->pow(*job.cipher, cp.exp);
+	}
+}
+
+bool PrivateKey::setLowLatency(bool on){
+	bool possible = (std::thread::hardware_concurrency() >= 2);
+	std::shared_ptr<SpinWorker> worker;
+	if(on && possible){
+		worker = std::atomic_load(&lowLatencyWorker);
+		if(!worker){
+			worker = std::make_shared<SpinWorker>();
+		}
+	}
+	std::atomic_store(&lowLatencyWorker, worker);
+	return possible || !on;
+}
+
+bool PrivateKey::getLowLatency(){
+	return (bool)std::atomic_load(&lowLatencyWorker);
+}
+
+BigNum PrivateKey::sign(const BigNum& msg) const{
+	return decrypt(msg);
+}
+
+// out[i] = key.decrypt(in[i]) for every step-th i from first.
+static void decryptRange(const PrivateKey* key, const std::vector<BigNum>* in,
+		std::vector<BigNum>* out, size_t first, size_t step){
+	for(size_t i=first; i<in->size(); i+=step){
+		(*out)[i] = key->decrypt((*in)[i]);
+	}
+}
+
+// Thread t takes ciphertexts t, t + threads, ...; the calling thread is thread 0.
+std::vector<BigNum> PrivateKey::decryptBatch(const std::vector<BigNum>& ciphers) const{
+	std::vector<BigNum> response(ciphers.size());
+	size_t threads = 1;
+	if(n.bitLength() >= DECRYPT_BATCH_THREAD_BITS){
+		threads = std::max(std::thread::hardware_concurrency(), 1u);
+		threads = std::min(threads, ciphers.size());
+	}
+	std::vector<std::thread> pool;
+	for(size_t t=1; t<threads; t++){
+		pool.push_back(std::thread(decryptRange, this, &ciphers, &response, t, threads));
+	}
+	decryptRange(this, &ciphers, &response, 0, threads);
+	for(size_t t=0; t<pool.size(); t++){
+		pool[t].join();
+	}
+	return response;
+}
+
+PublicKey PrivateKey::getPublicKey() const{
+	return PublicKey(n, e);
+}
+
+}
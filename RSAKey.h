@@ -0,0 +1,220 @@
+#ifndef RSAKEY_H_
+#define RSAKEY_H_
+#include <memory>
+#include <vector>
+#include "BigNum.h"
+#include "Montgomery.h"
+
+//decryptBatch() spreads a batch over threads only for moduli of at least this many
+//bits.  A 512 bit CRT decryption takes about four times as long as starting and
+//joining a thread; the toy keys below it take a fraction of that.
+#define DECRYPT_BATCH_THREAD_BITS 512
+
+namespace RSAUtil
+{
+
+/****************************************************************************************
+ * Immutable RSA key objects.  Everything a key needs for its operations (the
+ * Montgomery contexts and, for private keys, the CRT exponents and coefficient) is
+ * computed in the constructor, and no method changes the object afterwards, so one
+ * key can be used by any number of threads at once without locking.  Copies share
+ * the precomputed tables.
+ *
+ * RSA objects build these keys (see RSA::buildPublicKey() and
+ * RSA::buildPrivateKey()); they can also be constructed directly.
+ *
+ * @class: PublicKey, PrivateKey
+ * @namespace: RSAUtil
+ * @file: RSAKey.h
+ * @version: 1.0.0.0
+ * @date: 10/18/2026
+ * **************************************************************************************
+ */
+class PublicKey
+{
+private:
+	//modulus.
+	BigNum n;
+	//public exponent.
+	BigNum e;
+	//Montgomery context for n; null when n is even.
+	std::shared_ptr<const MontContext> mont;
+	//k when e = 2^k + 1 (3, 65537, ...), else 0.
+	int fermatBits;
+
+public:
+	/*
+	 * *******************************************************************************
+	 * Constructor.
+	 * @parameter BigNum:	The modulus n.
+	 * @parameter BigNum:	The public exponent e.
+	 * *******************************************************************************
+	 */
+	PublicKey(const BigNum&, const BigNum&);
+	virtual ~PublicKey();
+
+	const BigNum& getModulus() const;
+	const BigNum& getExponent() const;
+
+	/*
+	 * *******************************************************************************
+	 * encrypt.	Calculates m^e mod n.  For e = 2^k + 1 this is k squarings and one
+	 * 			multiplication.
+	 * *******************************************************************************
+	 */
+	BigNum encrypt(const BigNum&) const;
+
+	/*
+	 * *******************************************************************************
+	 * verify.	Checks a signature.
+	 * @parameter BigNum:	The message.
+	 * @parameter BigNum:	The signature.
+	 * @returns bool:	True if signature^e mod n equals the message.
+	 * *******************************************************************************
+	 */
+	bool verify(const BigNum&, const BigNum&) const;
+
+	/*
+	 * *******************************************************************************
+	 * verifyBatch.	Checks many signatures at once by screening: the batch passes if
+	 * 				(s1*s2*...*sk)^e == m1*m2*...*mk mod n, which costs one
+	 * 				exponentiation and 2k modular multiplications.  A failing batch is
+	 * 				split in half and each half screened again, down to single
+	 * 				entries, which are checked with verify().  Entries with a zero
+	 * 				message or a signature that is 0 mod n are checked with verify()
+	 * 				up front, and a batch whose signature product shares a factor
+	 * 				with n counts as failing, since either would let the products
+	 * 				match whatever the other entries are.  Screening accepts
+	 * 				every batch of valid signatures, but (like any product test) it
+	 * 				cannot tell a valid batch from one whose forged factors cancel
+	 * 				out, e.g. s1*a and s2/a.
+	 * @parameter std::vector<BigNum>:	The messages.
+	 * @parameter std::vector<BigNum>:	The signatures, one per message.
+	 * @returns std::vector<size_t>:	Indices of the entries that failed, in
+	 * 									increasing order; empty if all passed.
+	 * *******************************************************************************
+	 */
+	std::vector<size_t> verifyBatch(const std::vector<BigNum>&,
+			const std::vector<BigNum>&) const;
+};
+
+class PrivateKey
+{
+private:
+	//One prime factor with its CRT values.
+	struct CRTPrime
+	{
+		BigNum prime;
+		//d mod (prime-1).
+		BigNum exp;
+		//product of the primes before this one, and its inverse mod prime.
+		BigNum prefix;
+		BigNum coeff;
+		//Montgomery context for prime.
+		std::shared_ptr<const MontContext> mont;
+	};
+
+	//modulus, public and private exponents.
+	BigNum n;
+	BigNum e;
+	BigNum d;
+	//prime factors of n, empty if they are not known.
+	std::vector<BigNum> primes;
+	//CRT values, one entry per prime; empty when CRT is not used.
+	std::vector<CRTPrime> crtPrimes;
+	//Montgomery context for n; null for even moduli or when CRT is used.
+	std::shared_ptr<const MontContext> montN;
+
+	//The exponentiations decrypt() hands to the low latency worker: cipher^exp mod
+	//prime for every step-th prime from first.
+	struct CRTJob
+	{
+		const std::vector<CRTPrime>* primes;
+		const BigNum* cipher;
+		std::vector<BigNum>* out;
+		size_t first;
+		size_t step;
+	};
+	static void crtPowers(void*);
+
+	void precompute();
+
+public:
+	/*
+	 * *******************************************************************************
+	 * Constructors.
+	 * PrivateKey(p, q, e, d): A key with known factors.  Decryption uses the Chinese
+	 * 					Remainder Theorem when p and q are distinct, odd and coprime.
+	 * 					The factors are not tested for primality.
+	 * PrivateKey(primes, e, d): A multi-prime key, n = the product of the primes.
+	 * 					Decryption uses the CRT under the same conditions, with one
+	 * 					exponentiation per prime.
+	 * PrivateKey(n, e, d): A key without factors.  Decryption is c^d mod n.
+	 * *******************************************************************************
+	 */
+	PrivateKey(const BigNum&, const BigNum&, const BigNum&, const BigNum&);
+	PrivateKey(const std::vector<BigNum>&, const BigNum&, const BigNum&);
+	PrivateKey(const BigNum&, const BigNum&, const BigNum&);
+	virtual ~PrivateKey();
+
+	const BigNum& getModulus() const;
+	const BigNum& getPublicExponent() const;
+	const BigNum& getExponent() const;
+	//The first two prime factors, or 0 if the factors are not known.
+	BigNum getP() const;
+	BigNum getQ() const;
+	const std::vector<BigNum>& getPrimes() const;
+
+	/*
+	 * *******************************************************************************
+	 * usesCRT.	True if decryption splits into one exponentiation per prime factor.
+	 * *******************************************************************************
+	 */
+	bool usesCRT() const;
+
+	/*
+	 * *******************************************************************************
+	 * decrypt / sign.	Both calculate c^d mod n.
+	 * *******************************************************************************
+	 */
+	BigNum decrypt(const BigNum&) const;
+	BigNum sign(const BigNum&) const;
+
+	/*
+	 * *******************************************************************************
+	 * setLowLatency.	Opt-in mode for single large decryptions: the CRT
+	 * 				exponentiations (each with its own window table) are split
+	 * 				between the calling thread and a shared SpinWorker, which roughly
+	 * 				halves the time a two-prime decrypt() takes when a core is free.
+	 * 				The worker spins while idle, so the mode costs a core.  A decrypt()
+	 * 				that finds the worker busy with another thread's runs alone.
+	 * 				Applies to every PrivateKey in the process.
+	 * @parameter bool:	True to turn the mode on, false to turn it off.
+	 * @returns bool:	False if it was asked for on a machine with a single core,
+	 * 					where it stays off.
+	 * *******************************************************************************
+	 */
+	static bool setLowLatency(bool);
+	static bool getLowLatency();
+
+	/*
+	 * *******************************************************************************
+	 * decryptBatch.	Decrypts many ciphertexts; element i of the result is
+	 * 					decrypt(element i of the input).  For moduli of
+	 * 					DECRYPT_BATCH_THREAD_BITS or more the batch is split between
+	 * 					the calling thread and up to one thread per further core.
+	 * *******************************************************************************
+	 */
+	std::vector<BigNum> decryptBatch(const std::vector<BigNum>&) const;
+
+	/*
+	 * *******************************************************************************
+	 * getPublicKey.	The matching public key.
+	 * *******************************************************************************
+	 */
+	PublicKey getPublicKey() const;
+};
+
+}
+
+#endif /*RSAKEY_H_*/
@@ -0,0 +1,90 @@
+#include "SpinWorker.h"
+#include <chrono>
+
+namespace RSAUtil
+{
+
+#define JOB_NONE 0
+#define JOB_POSTED 1
+#define JOB_DONE 2
+
+// One step of a spin loop: tells the CPU, and every so often the scheduler, that
+// this thread is only waiting.
+static inline void spinPause(unsigned int& spins){
+#if defined(__x86_64__) && defined(__GNUC__)
+	__builtin_ia32_pause();
+#endif
+	if((++spins & 1023) == 0){
+		std::this_thread::yield();
+	}
+}
+
+SpinWorker::SpinWorker()
+	: claimed(false), job(JOB_NONE), task(0), arg(0), sleeping(false), stopping(false)
+{
+	thread = std::thread(&SpinWorker::run, this);
+}
+
+SpinWorker::~SpinWorker()
+{
+	{
+		std::lock_guard<std::mutex> guard(sleepLock);
+		stopping = true;
+	}
+	wake.notify_one();
+	thread.join();
+}
+
+bool SpinWorker::tryRun(void (*fn)(void*), void* fnArg){
+	bool expected = false;
+	if(!claimed.compare_exchange_strong(expected, true, std::memory_order_acquire)){
+		return false;
+	}
+	task = fn;
+	arg = fnArg;
+	job.store(JOB_POSTED);
+	//Seen asleep after the job was posted: it may have checked for a job before the
+	//post, so wake it, under the lock so the wake-up cannot come before its wait.
+	if(sleeping.load()){
+		std::lock_guard<std::mutex> guard(sleepLock);
+		wake.notify_one();
+	}
+	return true;
+}
+
+void SpinWorker::wait(){
+	unsigned int spins = 0;
+	while(job.load(std::memory_order_acquire) != JOB_DONE){
+		spinPause(spins);
+	}
+	job.store(JOB_NONE, std::memory_order_relaxed);
+	claimed.store(false, std::memory_order_release);
+}
+
+// Body of the worker thread: spin for a job, sleep after a long idle spell, run it.
+void SpinWorker::run(){
+	typedef std::chrono::steady_clock clock;
+	while(!stopping.load()){
+		clock::time_point idleSince = clock::now();
+		unsigned int spins = 0;
+		while(job.load(std::memory_order_acquire) != JOB_POSTED && !stopping.load()){
+			spinPause(spins);
+			if((spins & 255) == 0
+					&& clock::now() - idleSince > std::chrono::microseconds(SPIN_WORKER_SPIN_US)){
+				std::unique_lock<std::mutex> guard(sleepLock);
+				sleeping.store(true);
+				while(job.load() != JOB_POSTED && !stopping.load()){
+					wake.wait(guard);
+				}
+				sleeping.store(false);
+			}
+		}
+		if(stopping.load()){
+			break;
+		}
+		task(arg);
+		job.store(JOB_DONE, std::memory_order_release);
+	}
+}
+
+}
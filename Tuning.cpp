@@ -0,0 +1,332 @@
+#include "Tuning.h"
+#include "Limb.h"
+#include "Montgomery.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <vector>
+
+namespace RSAUtil
+{
+
+//Karatsuba on fewer limbs would recurse on operands no shorter than its own.
+#define TUNING_MIN_KARATSUBA 4
+//Each timing repeats the operation for at least this long.
+#define TUNING_SAMPLE_NS 2000000
+
+Tuning::Tuning()
+	: karatsubaMul(LIMB_KARATSUBA_CUTOFF), karatsubaSqr(LIMB_KARATSUBA_CUTOFF),
+	nttMul(LIMB_NTT_MUL_CUTOFF), nttSqr(LIMB_NTT_SQR_CUTOFF), montgomeryMinLimbs(2)
+{
+	static const int windows[TUNING_MAX_WINDOW + 1] = {0, 0, 23, 23, 79, 239, 671};
+	for(int k=0; k<=TUNING_MAX_WINDOW; k++){
+		windowAbove[k] = windows[k];
+	}
+}
+
+Tuning::~Tuning()
+{
+}
+
+bool Tuning::load(const std::string& file){
+	std::ifstream in(file.c_str());
+	if(!in){
+		return false;
+	}
+	bool ok = true;
+	std::string line;
+	while(std::getline(in, line)){
+		size_t start = line.find_first_not_of(" \t\r");
+		if(start == std::string::npos || line[start] == '#'){
+			continue;
+		}
+		size_t eq = line.find('=', start);
+		char* end = 0;
+		long value = (eq == std::string::npos) ? 0 : std::strtol(line.c_str() + eq + 1, &end, 10);
+		if(eq == std::string::npos || end == line.c_str() + eq + 1){
+			ok = false;
+			continue;
+		}
+		std::string name = line.substr(start, line.find_last_not_of(" \t", eq - 1) + 1 - start);
+		if(name == "karatsuba_mul" || name == "karatsuba_sqr"){
+			if(value >= TUNING_MIN_KARATSUBA && value <= (1 << 20)){
+				(name == "karatsuba_mul" ? karatsubaMul : karatsubaSqr) = (int)value;
+			}
+		}
+		else if(name == "ntt_mul" || name == "ntt_sqr"){
+			if(value >= 1 && value <= (1 << 30)){
+				(name == "ntt_mul" ? nttMul : nttSqr) = (int)value;
+			}
+		}
+		else if(name == "montgomery_min_limbs"){
+			if(value >= 2 && value <= (1 << 20)){
+				montgomeryMinLimbs = (int)value;
+			}
+		}
+		else if(name.compare(0, 7, "window_") == 0 && name.size() == 8
+				&& name[7] >= '2' && name[7] <= '0' + TUNING_MAX_WINDOW){
+			if(value >= 0 && value <= (1 << 30)){
+				windowAbove[name[7] - '0'] = (int)value;
+			}
+		}
+		else{
+			ok = false;
+		}
+	}
+	return ok;
+}
+
+bool Tuning::save(const std::string& file) const{
+	std::string tmp = file + ".tmp";
+	std::ofstream out(tmp.c_str());
+	out << "# RSAUtil tuning (see Tuning.h)\n"
+		<< "karatsuba_mul=" << karatsubaMul << "\n"
+		<< "karatsuba_sqr=" << karatsubaSqr << "\n"
+		<< "ntt_mul=" << nttMul << "\n"
+		<< "ntt_sqr=" << nttSqr << "\n"
+		<< "montgomery_min_limbs=" << montgomeryMinLimbs << "\n";
+	for(int k=2; k<=TUNING_MAX_WINDOW; k++){
+		out << "window_" << k << "=" << windowAbove[k] << "\n";
+	}
+	out.close();
+	if(!out){
+		std::remove(tmp.c_str());
+		return false;
+	}
+	return std::rename(tmp.c_str(), file.c_str()) == 0;
+}
+
+//Operands for one timed operation.
+struct Bench
+{
+	limb_t* r;
+	limb_t* a;
+	limb_t* b;
+	limb_t* m;
+	limb_t* t;
+	int n;
+	int cutoff;
+	const MontContext* ctx;
+};
+
+static void benchMul(const Bench& x){
+	limbMulCutoff(x.t, x.a, x.n, x.b, x.n, x.cutoff);
+}
+
+static void benchSqr(const Bench& x){
+	limbSqrCutoff(x.t, x.a, x.n, x.cutoff);
+}
+
+static void benchNttMul(const Bench& x){
+	limbMulNTT(x.t, x.a, x.n, x.b, x.n);
+}
+
+static void benchNttSqr(const Bench& x){
+	limbMulNTT(x.t, x.a, x.n, x.a, x.n);
+}
+
+static void benchDivMul(const Bench& x){
+	limbMul(x.t, x.a, x.n, x.b, x.n);
+	limbDivRem(0, x.r, x.t, 2*x.n, x.m, x.n);
+}
+
+static void benchMontMul(const Bench& x){
+	x.ctx->mulLazy(x.r, x.a, x.b, x.t);
+}
+
+static void benchMontSqr(const Bench& x){
+	x.ctx->sqrLazy(x.r, x.a, x.t);
+}
+
+// Nanoseconds per call: the best of five runs, each long enough to time.
+static double timeOf(void (*fn)(const Bench&), const Bench& x){
+	typedef std::chrono::steady_clock clock;
+	long reps = 1;
+	double best = 0;
+	for(int run=0; run<5; run++){
+		for(;;){
+			clock::time_point start = clock::now();
+			for(long i=0; i<reps; i++){
+				fn(x);
+			}
+			double ns = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+			if(ns < TUNING_SAMPLE_NS){
+				reps *= 2;
+				continue;
+			}
+			if(run == 0 || ns/reps < best){
+				best = ns/reps;
+			}
+			break;
+		}
+	}
+	return best;
+}
+
+// The smallest size at which Karatsuba beat schoolbook there and at the next size
+// tried, or fallback if it never did.
+static int karatsubaCutoff(void (*fn)(const Bench&), Bench x, int fallback){
+	static const int sizes[] = {8, 12, 16, 20, 24, 28, 32, 40, 48, 56, 64, 80, 96, 128};
+	const int count = sizeof(sizes)/sizeof(sizes[0]);
+	bool wins[count];
+	for(int i=0; i<count; i++){
+		x.n = sizes[i];
+		x.cutoff = sizes[i] + 1;
+		double school = timeOf(fn, x);
+		x.cutoff = sizes[i];
+		wins[i] = timeOf(fn, x) < school;
+	}
+	for(int i=0; i<count; i++){
+		if(wins[i] && (i+1 == count || wins[i+1])){
+			return sizes[i];
+		}
+	}
+	return fallback;
+}
+
+// The smallest size at which the NTT beat Karatsuba (fn, at x.cutoff) there and at
+// the next size tried.  The sizes stop where Karatsuba takes about a tenth of a
+// second; if the NTT did not win there, the cutoff is put past them.
+static int nttCutoff(void (*fn)(const Bench&), void (*ntt)(const Bench&), Bench x){
+	static const int sizes[] = {1024, 2048, 4096, 8192, 16384, 32768};
+	const int count = sizeof(sizes)/sizeof(sizes[0]);
+	bool wins[count];
+	for(int i=0; i<count; i++){
+		x.n = sizes[i];
+		wins[i] = timeOf(ntt, x) < timeOf(fn, x);
+		if(i > 0 && wins[i-1] && wins[i]){
+			return sizes[i-1];
+		}
+	}
+	return wins[count-1] ? sizes[count-1] : 2*sizes[count-1];
+}
+
+// Expected cost, in products, of a k-bit window exponentiation with an e-bit
+// exponent when a square costs ratio products: the table, one square per bit and
+// one product per window.
+static double windowCost(int k, int ebits, double ratio){
+	double cost = (ebits - 1)*ratio + (double)ebits/(k + 1);
+	if(k > 1){
+		cost += ratio + (1 << (k-1)) - 1;
+	}
+	return cost;
+}
+
+Tuning Tuning::measure(){
+	Tuning tuned;
+	const int maxLimbs = 128;
+	std::mt19937_64 random(1);
+	std::vector<limb_t> a(maxLimbs), b(maxLimbs), m(maxLimbs), r(maxLimbs), t(4*maxLimbs + 4);
+	for(int i=0; i<maxLimbs; i++){
+		a[i] = random();
+		b[i] = random();
+		m[i] = random();
+	}
+	Bench x = {&r[0], &a[0], &b[0], &m[0], &t[0], 0, 0, 0};
+
+	tuned.karatsubaMul = karatsubaCutoff(benchMul, x, tuned.karatsubaMul);
+	tuned.karatsubaSqr = karatsubaCutoff(benchSqr, x, tuned.karatsubaSqr);
+	{
+		const int nttLimbs = 32768;
+		std::vector<limb_t> na(nttLimbs), nb(nttLimbs), nt(2*nttLimbs);
+		for(int i=0; i<nttLimbs; i++){
+			na[i] = random();
+			nb[i] = random();
+		}
+		Bench y = {0, &na[0], &nb[0], 0, &nt[0], 0, tuned.karatsubaMul, 0};
+		tuned.nttMul = nttCutoff(benchMul, benchNttMul, y);
+		y.cutoff = tuned.karatsubaSqr;
+		tuned.nttSqr = nttCutoff(benchSqr, benchNttSqr, y);
+	}
+	//The products below are timed with the cutoffs just found.
+	Tuning previous = current();
+	Tuning withCutoffs = previous;
+	withCutoffs.karatsubaMul = tuned.karatsubaMul;
+	withCutoffs.karatsubaSqr = tuned.karatsubaSqr;
+	apply(withCutoffs);
+
+	//Montgomery against division, on moduli with the top bit set; operands below n.
+	std::vector<bool> montWins(17, false);
+	for(int n=2; n<=16; n++){
+		BigNum modulus;
+		m[n-1] |= (limb_t)1 << (LIMB_BITS - 1);
+		m[0] |= 1;
+		modulus.setLimbs(&m[0], n);
+		MontContext ctx(modulus);
+		limb_t topA = a[n-1], topB = b[n-1];
+		a[n-1] >>= 1;
+		b[n-1] >>= 1;
+		x.n = n;
+		x.ctx = &ctx;
+		montWins[n] = timeOf(benchMontMul, x) < timeOf(benchDivMul, x);
+		a[n-1] = topA;
+		b[n-1] = topB;
+	}
+	tuned.montgomeryMinLimbs = 17;
+	for(int n=16; n>=2 && montWins[n]; n--){
+		tuned.montgomeryMinLimbs = n;
+	}
+
+	//Square to product ratio per modulus size, then the best window per exponent
+	//length, taking the modulus to be about as long as the exponent.
+	std::vector<double> ratio(maxLimbs + 1, 0);
+	for(int n=2; n<=maxLimbs; n*=2){
+		BigNum modulus;
+		m[n-1] |= (limb_t)1 << (LIMB_BITS - 1);
+		m[0] |= 1;
+		modulus.setLimbs(&m[0], n);
+		MontContext ctx(modulus);
+		x.n = n;
+		x.ctx = &ctx;
+		ratio[n] = timeOf(benchMontSqr, x) / timeOf(benchMontMul, x);
+	}
+	for(int k=2; k<=TUNING_MAX_WINDOW; k++){
+		tuned.windowAbove[k] = 1 << 30;
+	}
+	for(int ebits=2; ebits<=LIMB_BITS*maxLimbs; ebits++){
+		int n = 2;
+		while(2*n <= maxLimbs && 2*n*LIMB_BITS <= ebits){
+			n *= 2;
+		}
+		int best = 1;
+		for(int k=2; k<=TUNING_MAX_WINDOW; k++){
+			if(windowCost(k, ebits, ratio[n]) < windowCost(best, ebits, ratio[n])){
+				best = k;
+			}
+		}
+		for(int k=2; k<=best; k++){
+			if(tuned.windowAbove[k] == (1 << 30)){
+				tuned.windowAbove[k] = ebits - 1;
+			}
+		}
+	}
+
+	apply(previous);
+	return tuned;
+}
+
+static Tuning loadCurrent(){
+	Tuning tuning;
+	const char* file = std::getenv(TUNING_ENV);
+	tuning.load((file && *file) ? file : TUNING_FILE);
+	return tuning;
+}
+
+// Never destroyed, like sievePrimes() in RSA.cpp: prime pool producers multiply
+// with it until they are joined, which may be during static destruction.
+static Tuning& active(){
+	static Tuning& tuning = *new Tuning(loadCurrent());
+	return tuning;
+}
+
+const Tuning& Tuning::current(){
+	return active();
+}
+
+void Tuning::apply(const Tuning& tuning){
+	active() = tuning;
+}
+
+}
@@ -0,0 +1,102 @@
+#ifndef TUNING_H_
+#define TUNING_H_
+#include <string>
+
+namespace RSAUtil
+{
+
+//Environment variable naming the tuning file Tuning::current() reads; without it
+//TUNING_FILE in the working directory is used.
+#define TUNING_ENV "RSAUTIL_TUNING"
+#define TUNING_FILE "rsautil-tuning.conf"
+
+//Widest sliding window the exponentiations use.
+#define TUNING_MAX_WINDOW 6
+
+/****************************************************************************************
+ * The algorithm thresholds that depend on the CPU rather than on the arithmetic:
+ *
+ *	karatsubaMul / karatsubaSqr:	operand length, in limbs, from which limbMul and
+ *									limbSqr switch from schoolbook to Karatsuba.
+ *	nttMul / nttSqr:	operand length from which they switch to number-theoretic
+ *									transforms (limbMulNTT).
+ *	montgomeryMinLimbs:	modulus length from which modPow() uses Montgomery
+ *									multiplication for odd moduli instead of long
+ *									division after every product.
+ *	windowAbove[k]:		exponent length, in bits, above which the sliding window
+ *									exponentiations use windows of k bits or more
+ *									(see expWindowBits).
+ *
+ * The defaults are the compiled-in values.  current() replaces them with those in the
+ * tuning file, if there is one; measure() finds values for this CPU by timing the
+ * limb kernels, and save() writes them out (see rsatune.cpp).  The file has one
+ * "name=value" line per threshold, with '#' comments, and names left out keep
+ * their defaults.
+ *
+ * @class: Tuning
+ * @namespace: RSAUtil
+ * @file: Tuning.h
+ * @version: 1.0.0.0
+ * @date: 10/18/2026
+ * **************************************************************************************
+ */
+class Tuning
+{
+public:
+	int karatsubaMul;
+	int karatsubaSqr;
+	int nttMul;
+	int nttSqr;
+	int montgomeryMinLimbs;
+	int windowAbove[TUNING_MAX_WINDOW + 1];
+
+	/*
+	 * *******************************************************************************
+	 * Constructor.  The compiled-in defaults.
+	 * *******************************************************************************
+	 */
+	Tuning();
+	virtual ~Tuning();
+
+	/*
+	 * *******************************************************************************
+	 * load.	Reads a tuning file over these values.  Values out of range are
+	 * 			ignored.
+	 * @returns bool:	False if the file could not be read or has a line that is not
+	 * 					a known name with a number.
+	 * save.	Writes these values as a tuning file, through a temporary file
+	 * 			renamed over it.
+	 * @returns bool:	False if the file could not be written.
+	 * *******************************************************************************
+	 */
+	bool load(const std::string&);
+	bool save(const std::string&) const;
+
+	/*
+	 * *******************************************************************************
+	 * measure.	Times schoolbook against Karatsuba products, Karatsuba against NTT
+	 * 			products, Montgomery against division products and Montgomery
+	 * 			squares against products, and derives every threshold from those
+	 * 			timings.  Takes a few seconds, most of them on the NTT sizes.
+	 * 			The cutoffs it finds are in use while it times the rest, so the
+	 * 			same rule as for apply() holds.
+	 * @returns Tuning:	The thresholds for this CPU.
+	 * *******************************************************************************
+	 */
+	static Tuning measure();
+
+	/*
+	 * *******************************************************************************
+	 * current.	The thresholds in use, read on first use from the file named by
+	 * 			TUNING_ENV, or TUNING_FILE, or the defaults if there is none.
+	 * apply.	Replaces the thresholds in use, e.g. with the result of measure() at
+	 * 			startup.  Only safe while no other thread is doing arithmetic.
+	 * *******************************************************************************
+	 */
+	static const Tuning& current();
+	static void apply(const Tuning&);
+};
+
+}
+
+#endif /*TUNING_H_*/
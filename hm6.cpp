@@ -1,10 +1,18 @@
 #include <cmath>
 #include <iostream>
+#include <vector>
 #include <math.h>
 #include <cstdlib>
 #include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <cstring>
+#include <string>
+#include <thread>
 #include "RSA.h"
+#include "BlindSigner.h"
 #include "BigInt.h"
+#include "RSADaemon.h"
 
 #define RAND_GEN32 0x7FFFFFFF
 #define RAND_GEN16 0xFFFF
@@ -12,15 +20,44 @@
 using namespace RSAUtil;
 using namespace std;
 
-BigInt getDecryptedMessageFromRSA_obj(BigInt m, RSA RSA_obj)
+BigNum getDecryptedMessageFromRSA_obj(BigNum m, RSA RSA_obj)
 {
 	return RSA_obj.decrypt(m);
 }
 
+//Connects to the daemon at path and sends text.  With halfClose the writing side is
+//shut down right after, and the returned connection only needs reading.
+int rawConnect(const string& path, const string& text, bool halfClose)
+{
+	struct sockaddr_un addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0 || connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || write(fd, text.data(), text.size()) != (ssize_t)text.size())
+		return -1;
+	if (halfClose)
+		shutdown(fd, SHUT_WR);
+	return fd;
+}
+
+//Everything the daemon sends on fd until it closes the connection.
+string rawReadAll(int fd)
+{
+	string response;
+	char buf[4096];
+	ssize_t got;
+	while (fd >= 0 && (got = read(fd, buf, sizeof(buf))) > 0)
+		response.append(buf, got);
+	if (fd >= 0)
+		close(fd);
+	return response;
+}
+
 int main(int argc, char*argv[])
 {
 	RSA* _RSA_obj[10];
-	BigInt _message, _encrypt, _decrypt;
+	BigNum _message, _encrypt, _decrypt;
 	int _primeNumber[] = { 40343,40351,40357,40361,40387,40423,40427,40429,40433,40459,40471,40483,40487,40493,40499,40507,40519,40529,40531};
 	int _nonPrimeNumber[] = {36782,36792,36792,36802,36822,36832,36842,36852,36872,36872,37692,37692,37692,37722,37742,37712,37782,37792,37812,37814};
 
@@ -83,8 +120,8 @@ cout<<"\n";
 cout << "2)--------------------Challenge response scheme--------------------" <<  "\n";
 RSA obj1, obj2;
 
-BigInt rsaPK = obj1.getPublicKey();
-BigInt rsaN = obj1.getModulus();
+BigNum rsaPK = obj1.getPublicKey();
+BigNum rsaN = obj1.getModulus();
 
 obj2.setPublicKey(rsaPK);
 obj2.setN(rsaN);
@@ -92,8 +129,8 @@ obj2.setN(rsaN);
 //random message
 _message = int(((double) rand() / RAND_MAX)*RAND_GEN32);
 
-BigInt encrypt = obj2.encrypt(_message);
-BigInt decrypt = obj1.decrypt(encrypt);
+BigNum encrypt = obj2.encrypt(_message);
+BigNum decrypt = obj1.decrypt(encrypt);
 
 cout << "Plain Text:" << _message.toHexString() << "\tDecrypted Text:" << decrypt.toHexString() <<  "\n";
 if (_message.operator==(decrypt))
@@ -107,26 +144,24 @@ cout <<  "\n";
 
 cout << "3)------------------Blind signature---------------------" <<  "\n";
 RSA obj;
-BigInt bobN = obj.getModulus();
-BigInt bobPK = obj.getPublicKey();
+BigNum bobN = obj.getModulus();
+BigNum bobPK = obj.getPublicKey();
 
-// Generate random number and its inverse
-double AliceRandomNo = double(((double) rand() / RAND_MAX)*RAND_GEN32);
-BigInt rnd(AliceRandomNo);
-BigInt AliceRandomNoInverse = RSAUtil::modInverse(rnd, bobN);
+//Alice blinds with Bob's public key; her pool of blinding factors fills in the background.
+BlindSigner alice(obj.buildPublicKey());
+BlindSigner bob(obj.buildPrivateKey(), 0);
 
 //random message
 _message = int(((double) rand() / RAND_MAX)*RAND_GEN32);
 
-BigInt encryptRandom = RSAUtil::modPow(rnd, bobPK, bobN);
+BigNum unblinder;
+BigNum messageToRSAobj = alice.blind(_message, unblinder);
 
-BigInt messageToRSAobj = encryptRandom.operator*(_message).operator%(bobN);
+BigNum messageFromRSAobj = bob.signBlinded(messageToRSAobj);
 
-BigInt messageFromRSAobj = getDecryptedMessageFromRSA_obj(messageToRSAobj, obj);
+BigNum sign = alice.unblind(messageFromRSAobj, unblinder);
 
-BigInt sign = messageFromRSAobj.operator*(AliceRandomNoInverse).operator%(bobN);
-
-BigInt flag = RSAUtil::modPow(sign, bobPK, bobN);
+BigNum flag = RSAUtil::modPow(sign, bobPK, bobN);
 
 cout << "message: " << _message.toHexString() << "\tsignature: " << sign.toHexString() << "\tdecrypted: " << flag.toHexString() <<  "\n";
 
@@ -136,6 +171,101 @@ if(_message.operator==(flag))
 else
 	cout << "Blind signature Unsuccessful" << "\n";
 
+//--------------Large keys---------------------------------------
+
+cout << "\n4)------------------Large keys---------------------" <<  "\n";
+int _keyBits[] = {1024, 2048};
+for (int i = 0; i < 2; i++)
+{
+	RSA big(KeySpec(_keyBits[i]));
+	_message = BigNum::fromHex("0x0123456789ABCDEF0123456789ABCDEF");
+	_encrypt = big.encrypt(_message);
+	_decrypt = big.decrypt(_encrypt);
+	cout << _keyBits[i] << " bit key: n has " << big.getModulus().bitLength() << " bits, generated in "
+		<< big.getKeyGenTime() << " ms, decryption " << (_decrypt == _message ? "Successful" : "Unsuccessful") << "\n";
+}
+
+//--------------Batch verification---------------------------------------
+
+cout << "\n5)------------------Batch verification---------------------" <<  "\n";
+PublicKey bobPublic = obj.buildPublicKey();
+PrivateKey bobPrivate = obj.buildPrivateKey();
+vector<BigNum> msgs, sigs;
+for (int i = 0; i < 4; i++)
+{
+	msgs.push_back(BigNum(int(((double) rand() / RAND_MAX)*RAND_GEN32)));
+	sigs.push_back(bobPrivate.decrypt(msgs[i]));
+}
+//Entries 1 and 3 are forged, 4 is the valid pair (0, 0) and 5 a valid signature
+//sharing a factor with n; 6 and 7 are forged so that both products are 0 mod n.
+sigs[1] += 1;
+sigs[3] += 1;
+msgs.push_back(BigNum(0));
+sigs.push_back(BigNum(0));
+msgs.push_back(bobPublic.encrypt(obj.getP()));
+sigs.push_back(obj.getP());
+msgs.push_back(obj.getQ());
+sigs.push_back(obj.getP());
+msgs.push_back(obj.getP());
+sigs.push_back(obj.getQ());
+vector<size_t> bad = bobPublic.verifyBatch(msgs, sigs);
+cout << "rejected entries:";
+for (size_t i = 0; i < bad.size(); i++)
+	cout << " " << bad[i];
+size_t expected[] = {1, 3, 6, 7};
+cout << "\nBatch verification: " << (bad == vector<size_t>(expected, expected + 4) ? "Successful" : "Unsuccessful") << "\n";
+
+//--------------RSA daemon---------------------------------------
+
+cout << "\n6)------------------RSA daemon---------------------" <<  "\n";
+string sockPath = "/tmp/hm6-rsad-" + to_string(getpid()) + ".sock";
+RSADaemon rsad(sockPath);
+rsad.addKey("bob", bobPrivate);
+//A window long enough that requests are still queued when their client half-closes.
+rsad.setBatchWindow(50000, 64);
+thread server([&rsad]() { rsad.run(); });
+RSAClient client;
+for (int i = 0; i < 200 && !client.connect(sockPath); i++)
+	usleep(10000);
+
+bool daemonOk = true;
+BigNum dmsg = msgs[0], dcipher, dplain, dsig;
+daemonOk &= client.encrypt("bob", dmsg, dcipher) && dcipher == bobPublic.encrypt(dmsg);
+daemonOk &= client.decrypt("bob", dcipher, dplain) && dplain == dmsg;
+daemonOk &= client.sign("bob", dmsg, dsig) && bobPublic.verify(dmsg, dsig);
+string pub = client.request("PUB bob");
+string enc2 = client.request("ENC bob 0x2");
+daemonOk &= pub.compare(0, 3, "OK ") == 0 && enc2.compare(0, 3, "OK ") == 0;
+cout << "ENC/DEC/SIGN/PUB: " << (daemonOk ? "Successful" : "Unsuccessful") << "\n";
+
+bool errorsOk = client.request("DEC alice 0x2") == "ERR unknown key"
+	&& client.request("ENC bob") == "ERR bad argument"
+	&& client.request("SIGN bob 0xZZ") == "ERR bad argument"
+	&& client.request("FOO bob 0x2") == "ERR unknown request";
+cout << "Error replies: " << (errorsOk ? "Successful" : "Unsuccessful") << "\n";
+
+//Three requests in one write come back in order.
+string piped = rawReadAll(rawConnect(sockPath, "ENC bob 0x2\nPUB bob\nFOO\n", true));
+bool pipeOk = piped == enc2 + "\n" + pub + "\nERR unknown request\n";
+cout << "Pipelining: " << (pipeOk ? "Successful" : "Unsuccessful") << "\n";
+
+//A client that half-closes while its request is queued still gets the reply, and a
+//client connecting after it (possibly on the same fd) gets only its own.
+int first = rawConnect(sockPath, "ENC bob 0x2\n", true);
+usleep(10000);
+string second = rawReadAll(rawConnect(sockPath, "PUB bob\n", true));
+bool halfOk = rawReadAll(first) == enc2 + "\n" && second == pub + "\n";
+cout << "Half-closed client: " << (halfOk ? "Successful" : "Unsuccessful") << "\n";
+
+string stats = client.request("STATS");
+//Both DECs and SIGNs above are counted, errors included; the unknown FOOs are not.
+bool statsOk = stats.compare(0, 9, "OK queue=") == 0 && stats.find(" DEC_count=2 ") != string::npos
+	&& stats.find(" SIGN_count=2 ") != string::npos && stats.find("FOO") == string::npos;
+cout << "STATS: " << (statsOk ? "Successful" : "Unsuccessful") << "\n";
+client.close();
+rsad.stop();
+server.join();
+
 //--------------------------------------end of main--------------------
 cout<<"\n";
 return 0;
@@ -0,0 +1,34 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "PrimeBitmap.h"
+
+using namespace RSAUtil;
+using namespace std;
+
+int main(int argc, char* argv[])
+{
+	if(argc > 2){
+		cerr << "usage: mkprimes [file]\n"
+			<< "  writes the bitmap of the primes below 2^32 to file, by default the one\n"
+			<< "  named by " PRIME_BITMAP_ENV " or " PRIME_BITMAP_FILE "\n";
+		return 1;
+	}
+	const char* env = getenv(PRIME_BITMAP_ENV);
+	string file = (argc == 2) ? argv[1] : ((env && *env) ? env : PRIME_BITMAP_FILE);
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	if(!PrimeBitmap::build(file)){
+		cerr << "mkprimes: cannot write " << file << "\n";
+		return 1;
+	}
+	double s = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	PrimeBitmap bitmap(file);
+	if(!bitmap.isOpen()){
+		cerr << "mkprimes: cannot map " << file << "\n";
+		return 1;
+	}
+	cout << file << " written in " << s << " s\n";
+	return 0;
+}
@@ -0,0 +1,119 @@
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <csignal>
+#include "RSA.h"
+#include "RSADaemon.h"
+#include "Tuning.h"
+
+using namespace RSAUtil;
+using namespace std;
+
+static RSADaemon* daemon_obj = 0;
+
+static void onSignal(int)
+{
+	if(daemon_obj){
+		daemon_obj->stop();
+	}
+}
+
+static void usage()
+{
+	cerr << "usage: rsad <socket> [-T auto|tuning_file] [-w window_us] [-b max_batch] [-k name:p:q]\n"
+		<< "            [-g name[:bits]]\n"
+		<< "  -T  tune the arithmetic for this CPU now (auto) or from a file written by\n"
+		<< "      rsatune, instead of from " TUNING_FILE "; give it before -k and -g\n"
+		<< "  -w  wait up to window_us for more requests before processing a batch (default\n"
+		<< "      0); a batch's decryptions are spread over the cores\n"
+		<< "  -b  process a batch as soon as max_batch requests are queued\n"
+		<< "  -k  serve the key built from primes p and q under name\n"
+		<< "  -g  serve a freshly generated key (2048 bits by default) under name\n"
+		<< "With no -k or -g, one generated key is served as \"default\".\n";
+}
+
+int main(int argc, char* argv[])
+{
+	if(argc < 2){
+		usage();
+		return 1;
+	}
+	RSADaemon rsad(argv[1]);
+	int window = 0, batch = 64, nkeys = 0;
+
+	for(int i=2; i<argc; i++){
+		string opt = argv[i];
+		if(i+1 >= argc){
+			usage();
+			return 1;
+		}
+		string val = argv[++i];
+		if(opt == "-T"){
+			Tuning tuning;
+			if(val == "auto"){
+				tuning = Tuning::measure();
+			}
+			else if(!tuning.load(val)){
+				cerr << "rsad: cannot read tuning from " << val << "\n";
+				return 1;
+			}
+			Tuning::apply(tuning);
+		}
+		else if(opt == "-w"){
+			window = atoi(val.c_str());
+		}
+		else if(opt == "-b"){
+			batch = atoi(val.c_str());
+		}
+		else if(opt == "-k"){
+			size_t a = val.find(':'), b = val.rfind(':');
+			if(a == string::npos || a == b){
+				usage();
+				return 1;
+			}
+			int p = atoi(val.substr(a+1, b-a-1).c_str()), q = atoi(val.substr(b+1).c_str());
+			if(!isPrime(p) || !isPrime(q) || p == q){
+				cerr << "rsad: " << val.substr(0, a) << ": p and q must be distinct primes\n";
+				return 1;
+			}
+			RSA RSA_obj(p, q);
+			rsad.addKey(val.substr(0, a), RSA_obj.buildPrivateKey());
+			cout << val.substr(0, a) << ": n=" << RSA_obj.getModulus().toHexString()
+				<< " e=" << RSA_obj.getPublicKey().toHexString() << "\n";
+			nkeys++;
+		}
+		else if(opt == "-g"){
+			size_t a = val.find(':');
+			int bits = (a == string::npos) ? 2048 : atoi(val.substr(a+1).c_str());
+			string name = val.substr(0, a);
+			RSA RSA_obj((KeySpec(bits)));
+			rsad.addKey(name, RSA_obj.buildPrivateKey());
+			cout << name << ": " << bits << " bit key generated in " << RSA_obj.getKeyGenTime()
+				<< " ms, n=" << RSA_obj.getModulus().toHexString()
+				<< " e=" << RSA_obj.getPublicKey().toHexString() << "\n";
+			nkeys++;
+		}
+		else{
+			usage();
+			return 1;
+		}
+	}
+	if(nkeys == 0){
+		RSA RSA_obj;
+		rsad.addKey("default", RSA_obj.buildPrivateKey());
+		cout << "default: n=" << RSA_obj.getModulus().toHexString()
+			<< " e=" << RSA_obj.getPublicKey().toHexString() << "\n";
+	}
+	rsad.setBatchWindow(window, batch);
+
+	daemon_obj = &rsad;
+	signal(SIGINT, onSignal);
+	signal(SIGTERM, onSignal);
+	cout << "listening on " << argv[1] << endl;
+	if(!rsad.run()){
+		cerr << "rsad: cannot listen on " << argv[1] << "\n";
+		return 1;
+	}
+	cout << rsad.statsLine() << endl;
+	return 0;
+}
@@ -0,0 +1,129 @@
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "RSA.h"
+#include "BatchGCD.h"
+
+using namespace RSAUtil;
+using namespace std;
+
+static void usage()
+{
+	cerr << "usage: rsagcd [-t threads] [-s spill_dir] [-g count:bits] [file]\n"
+		<< "  reads moduli, one per line, in hex (0x..., as toHexString() prints them)\n"
+		<< "  or decimal, from file or stdin, and reports every modulus that shares a\n"
+		<< "  prime with another one\n"
+		<< "  -t  threads to split each tree level between (default 1)\n"
+		<< "  -s  spill the product tree to spill_dir instead of keeping it in memory\n"
+		<< "  -g  also generate count keys of the given size and scan their moduli\n";
+}
+
+static bool readModuli(istream& in, vector<BigNum>& moduli, vector<string>& labels)
+{
+	string line;
+	for(int lineNo=1; getline(in, line); lineNo++){
+		size_t start = line.find_first_not_of(" \t\r");
+		if(start == string::npos || line[start] == '#'){
+			continue;
+		}
+		line = line.substr(start);
+		BigNum n = (line.size() > 1 && line[1] == 'x') ? BigNum::fromHex(line) : BigNum::fromDec(line);
+		if(n < 2){
+			cerr << "rsagcd: line " << lineNo << ": not a modulus\n";
+			return false;
+		}
+		moduli.push_back(n);
+		labels.push_back("line " + to_string(lineNo));
+	}
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	int threads = 1, genCount = 0, genBits = 2048;
+	string spillDir, file;
+
+	for(int i=1; i<argc; i++){
+		string opt = argv[i];
+		if(opt[0] != '-' && file.empty()){
+			file = opt;
+			continue;
+		}
+		if(i+1 >= argc){
+			usage();
+			return 1;
+		}
+		string val = argv[++i];
+		if(opt == "-t"){
+			threads = atoi(val.c_str());
+		}
+		else if(opt == "-s"){
+			spillDir = val;
+		}
+		else if(opt == "-g"){
+			size_t a = val.find(':');
+			genCount = atoi(val.substr(0, a).c_str());
+			if(a != string::npos){
+				genBits = atoi(val.substr(a+1).c_str());
+			}
+		}
+		else{
+			usage();
+			return 1;
+		}
+	}
+
+	vector<BigNum> moduli;
+	vector<string> labels;
+	if(!file.empty() || genCount == 0){
+		bool ok;
+		if(file.empty() || file == "-"){
+			ok = readModuli(cin, moduli, labels);
+		}
+		else{
+			ifstream in(file.c_str());
+			if(!in){
+				cerr << "rsagcd: cannot read " << file << "\n";
+				return 1;
+			}
+			ok = readModuli(in, moduli, labels);
+		}
+		if(!ok){
+			return 1;
+		}
+	}
+	for(int i=0; i<genCount; i++){
+		RSA key((KeySpec(genBits)));
+		moduli.push_back(key.getModulus());
+		labels.push_back("generated key " + to_string(i));
+	}
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	vector<BigNum> shared;
+	if(!BatchGCD(threads, spillDir).gcds(moduli, shared)){
+		cerr << "rsagcd: cannot spill to " << spillDir << "\n";
+		return 1;
+	}
+	double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+	int weak = 0;
+	for(size_t i=0; i<moduli.size(); i++){
+		if(shared[i] == 1){
+			continue;
+		}
+		weak++;
+		cout << labels[i] << ": n=" << moduli[i].toHexString() << "\n";
+		if(shared[i] == moduli[i]){
+			cout << "    every prime is also in other moduli (or it is duplicated)\n";
+		}
+		else{
+			cout << "    p=" << shared[i].toHexString() << "\n"
+				<< "    q=" << (moduli[i] / shared[i]).toHexString() << "\n";
+		}
+	}
+	cout << moduli.size() << " moduli scanned in " << ms << " ms, " << weak << " weak\n";
+	return weak ? 2 : 0;
+}
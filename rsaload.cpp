@@ -0,0 +1,265 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "RSA.h"
+#include "BlindSigner.h"
+#include "LatencyHistogram.h"
+#include "PrimePool.h"
+
+using namespace RSAUtil;
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+static const char* opNames[] = {"keygen", "encrypt", "decrypt", "challenge", "blind"};
+static const int OP_COUNT = 5;
+
+//Key material shared by every worker.
+struct Workload
+{
+	int bits;
+	PrivateKey* priv;
+	PublicKey* pub;
+	BlindSigner* signer;
+};
+
+//One worker's results.
+struct WorkerStats
+{
+	LatencyHistogram hist[OP_COUNT];
+	unsigned long long failures[OP_COUNT];
+};
+
+static void usage()
+{
+	cerr << "usage: rsaload [-o ops] [-c workers] [-r rate] [-d seconds] [-b bits] [-p depth] [-l 0|1]\n"
+		<< "               [-j file]\n"
+		<< "  -o  comma separated operations to run in turn, from keygen, encrypt,\n"
+		<< "      decrypt, challenge and blind (default: all but keygen)\n"
+		<< "  -c  number of concurrent workers (default 1)\n"
+		<< "  -r  target rate in operations per second over all workers; without it\n"
+		<< "      each worker starts its next operation as soon as the last one ends\n"
+		<< "  -d  run time in seconds (default 10)\n"
+		<< "  -b  key size in bits (default 2048)\n"
+		<< "  -p  take keygen primes from a pool kept depth primes deep per size\n"
+		<< "  -l  1 splits each decryption between two cores (PrivateKey::setLowLatency)\n"
+		<< "  -j  write the results as JSON to file (\"-\" for stdout)\n";
+}
+
+static BigNum randomBelow(mt19937_64& rng, const BigNum& n){
+	vector<limb_t> limbs(n.size());
+	for(size_t i=0; i<limbs.size(); i++){
+		limbs[i] = rng();
+	}
+	BigNum response;
+	response.setLimbs(&limbs[0], (int)limbs.size());
+	return response % n;
+}
+
+//Runs one operation; false if its result was wrong.
+static bool runOp(int op, const Workload& w, mt19937_64& rng){
+	const BigNum& n = w.pub->getModulus();
+	switch(op){
+		case 0:{
+			RSA fresh((KeySpec(w.bits)));
+			return fresh.getModulus().bitLength() == w.bits;
+		}
+		case 1:
+			w.pub->encrypt(randomBelow(rng, n));
+			return true;
+		case 2:
+			w.priv->decrypt(randomBelow(rng, n));
+			return true;
+		case 3:{
+			//hm6's challenge-response: the challenger encrypts a random number with
+			//the responder's public key and checks the decrypted reply.
+			BigNum challenge = randomBelow(rng, n);
+			return w.priv->decrypt(w.pub->encrypt(challenge)) == challenge;
+		}
+		default:{
+			BigNum msg = randomBelow(rng, n);
+			BigNum unblinder;
+			BigNum blinded = w.signer->blind(msg, unblinder);
+			BigNum sig = w.signer->unblind(w.signer->signBlinded(blinded), unblinder);
+			return w.pub->verify(msg, sig);
+		}
+	}
+}
+
+//Runs the operations in turn until the deadline.  With a rate, operation i is due
+//at start + i*interval and its latency is measured from that time, so a stall also
+//counts against the operations that queued up behind it.
+static void worker(const Workload& w, const vector<int>& ops, double interval,
+		Clock::time_point start, Clock::time_point deadline, unsigned int seed,
+		WorkerStats& stats){
+	mt19937_64 rng(seed);
+	for(unsigned long long i=0; ; i++){
+		Clock::time_point due = Clock::now();
+		if(interval > 0){
+			due = start + chrono::duration_cast<Clock::duration>(chrono::duration<double>(i*interval));
+			this_thread::sleep_until(due);
+		}
+		if(Clock::now() >= deadline){
+			break;
+		}
+		int op = ops[i % ops.size()];
+		bool ok = runOp(op, w, rng);
+		Clock::time_point end = Clock::now();
+		stats.hist[op].record(chrono::duration_cast<chrono::nanoseconds>(end - due).count());
+		if(!ok){
+			stats.failures[op]++;
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	string opList = "encrypt,decrypt,challenge,blind";
+	string jsonFile;
+	int workers = 1, bits = 2048, poolDepth = 0, lowLatency = 0;
+	double rate = 0, seconds = 10;
+
+	for(int i=1; i<argc; i++){
+		string opt = argv[i];
+		if(i+1 >= argc){
+			usage();
+			return 1;
+		}
+		string val = argv[++i];
+		if(opt == "-o"){
+			opList = val;
+		}
+		else if(opt == "-c"){
+			workers = atoi(val.c_str());
+		}
+		else if(opt == "-r"){
+			rate = atof(val.c_str());
+		}
+		else if(opt == "-d"){
+			seconds = atof(val.c_str());
+		}
+		else if(opt == "-b"){
+			bits = atoi(val.c_str());
+		}
+		else if(opt == "-p"){
+			poolDepth = atoi(val.c_str());
+		}
+		else if(opt == "-l"){
+			lowLatency = atoi(val.c_str());
+		}
+		else if(opt == "-j"){
+			jsonFile = val;
+		}
+		else{
+			usage();
+			return 1;
+		}
+	}
+
+	vector<int> ops;
+	stringstream list(opList);
+	string name;
+	while(getline(list, name, ',')){
+		int op = 0;
+		while(op < OP_COUNT && name != opNames[op]){
+			op++;
+		}
+		if(op == OP_COUNT){
+			cerr << "rsaload: unknown operation " << name << "\n";
+			usage();
+			return 1;
+		}
+		ops.push_back(op);
+	}
+	if(ops.empty() || workers < 1 || bits < 32 || seconds <= 0){
+		usage();
+		return 1;
+	}
+
+	if(poolDepth > 0){
+		RSA::setPrimePool(std::make_shared<PrimePool>(poolDepth));
+		RSA::reservePrimes(KeySpec(bits));
+	}
+	if(lowLatency && !PrivateKey::setLowLatency(true)){
+		cerr << "rsaload: low latency mode needs more than one core\n";
+	}
+	RSA keys((KeySpec(bits)));
+	cout << bits << " bit key generated in " << keys.getKeyGenTime() << " ms\n";
+	PrivateKey priv = keys.buildPrivateKey();
+	PublicKey pub = priv.getPublicKey();
+	BlindSigner signer(priv);
+	Workload w = {bits, &priv, &pub, &signer};
+
+	vector<WorkerStats> stats(workers);
+	vector<thread> threads;
+	double interval = (rate > 0) ? workers / rate : 0;
+	Clock::time_point start = Clock::now();
+	Clock::time_point deadline = start + chrono::duration_cast<Clock::duration>(chrono::duration<double>(seconds));
+	for(int i=0; i<workers; i++){
+		for(int op=0; op<OP_COUNT; op++){
+			stats[i].failures[op] = 0;
+		}
+		//Stagger the workers' schedules across one interval.
+		Clock::time_point first = start + chrono::duration_cast<Clock::duration>(
+				chrono::duration<double>(interval * i / workers));
+		threads.push_back(thread(worker, cref(w), cref(ops), interval, first, deadline,
+				1000u + i, ref(stats[i])));
+	}
+	for(size_t i=0; i<threads.size(); i++){
+		threads[i].join();
+	}
+	double elapsed = chrono::duration<double>(Clock::now() - start).count();
+
+	LatencyHistogram total[OP_COUNT];
+	unsigned long long failures[OP_COUNT] = {0};
+	for(int i=0; i<workers; i++){
+		for(int op=0; op<OP_COUNT; op++){
+			total[op].merge(stats[i].hist[op]);
+			failures[op] += stats[i].failures[op];
+		}
+	}
+
+	ostringstream json;
+	json << "{\"bits\": " << bits << ", \"workers\": " << workers << ", \"target_rate\": " << rate
+		<< ", \"prime_pool\": " << poolDepth
+		<< ", \"seconds\": " << elapsed << ", \"kernels\": \"" << limbKernelName() << "\", \"ops\": {";
+	bool first = true;
+	cout << "\nop          count    ops/s   p50(us)   p99(us) p99.9(us)   max(us) failed\n";
+	for(int op=0; op<OP_COUNT; op++){
+		const LatencyHistogram& h = total[op];
+		if(h.count() == 0){
+			continue;
+		}
+		double throughput = h.count() / elapsed;
+		printf("%-10s %6llu %8.1f %9.1f %9.1f %9.1f %9.1f %6llu\n", opNames[op], h.count(),
+				throughput, h.percentile(50)/1e3, h.percentile(99)/1e3, h.percentile(99.9)/1e3,
+				h.max()/1e3, failures[op]);
+		json << (first ? "" : ", ") << "\"" << opNames[op] << "\": {\"throughput\": " << throughput
+			<< ", \"failures\": " << failures[op] << ", \"latency\": " << h.toJson() << "}";
+		first = false;
+	}
+	json << "}}";
+
+	int status = 0;
+	if(jsonFile == "-"){
+		cout << json.str() << endl;
+	}
+	else if(!jsonFile.empty()){
+		ofstream out(jsonFile.c_str());
+		out << json.str() << "\n";
+		if(!out){
+			cerr << "rsaload: cannot write " << jsonFile << "\n";
+			status = 1;
+		}
+	}
+	//Stop the producers here rather than during static destruction.
+	RSA::setPrimePool(nullptr);
+	return status;
+}
@@ -0,0 +1,62 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "Tuning.h"
+
+using namespace RSAUtil;
+using namespace std;
+
+static void usage()
+{
+	cerr << "usage: rsatune [-n] [file]\n"
+		<< "  times the arithmetic kernels on this CPU and writes the thresholds to file,\n"
+		<< "  by default the one named by " TUNING_ENV " or " TUNING_FILE "\n"
+		<< "  -n  only print the thresholds\n";
+}
+
+int main(int argc, char* argv[])
+{
+	bool write = true;
+	string file;
+	for(int i=1; i<argc; i++){
+		string opt = argv[i];
+		if(opt == "-n"){
+			write = false;
+		}
+		else if(opt[0] != '-' && file.empty()){
+			file = opt;
+		}
+		else{
+			usage();
+			return 1;
+		}
+	}
+	if(file.empty()){
+		const char* env = getenv(TUNING_ENV);
+		file = (env && *env) ? env : TUNING_FILE;
+	}
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	Tuning tuned = Tuning::measure();
+	double s = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	Tuning defaults;
+
+	cout << "measured in " << s << " s (default in brackets)\n"
+		<< "karatsuba_mul=" << tuned.karatsubaMul << " (" << defaults.karatsubaMul << ")\n"
+		<< "karatsuba_sqr=" << tuned.karatsubaSqr << " (" << defaults.karatsubaSqr << ")\n"
+		<< "ntt_mul=" << tuned.nttMul << " (" << defaults.nttMul << ")\n"
+		<< "ntt_sqr=" << tuned.nttSqr << " (" << defaults.nttSqr << ")\n"
+		<< "montgomery_min_limbs=" << tuned.montgomeryMinLimbs << " (" << defaults.montgomeryMinLimbs << ")\n";
+	for(int k=2; k<=TUNING_MAX_WINDOW; k++){
+		cout << "window_" << k << "=" << tuned.windowAbove[k] << " (" << defaults.windowAbove[k] << ")\n";
+	}
+	if(write){
+		if(!tuned.save(file)){
+			cerr << "rsatune: cannot write " << file << "\n";
+			return 1;
+		}
+		cout << "written to " << file << "\n";
+	}
+	return 0;
+}